@@ -0,0 +1,52 @@
+#include "arena.h"
+
+#include <MicroBit.h>
+
+#include <cstring>
+
+namespace maze { namespace arena {
+
+namespace
+{
+
+// Image data header followed by the pixels, word aligned like heap blocks
+size_t constexpr sSlotSize = (sizeof (ImageData) + sSlotPixels + 3) & ~static_cast<size_t> (3);
+uint32_t sStorage [SlotCount][sSlotSize / 4];
+bool sUsed [SlotCount] = {};
+
+}
+
+MicroBitImage image (Slot const slot, uint16_t const width, uint16_t const height, uint8_t const* pixels)
+{
+  if (width * height > sSlotPixels)
+    microbit_panic (sPanicTooLarge);
+
+  auto* data = reinterpret_cast<ImageData*> (sStorage [slot]);
+  // read only reference count: never freed by MicroBitImage
+  data->refCount = 0xffff;
+  data->width = width;
+  data->height = height;
+  if (pixels)
+    memcpy (data->data, pixels, width * height);
+  else
+    memset (data->data, 0, width * height);
+
+  sUsed [slot] = true;
+  return MicroBitImage (data);
+}
+
+uint8_t used ()
+{
+  uint8_t count = 0;
+  for (auto const slot : sUsed)
+    if (slot)
+      ++count;
+  return count;
+}
+
+uint16_t usedBytes ()
+{
+  return used () * sSlotSize;
+}
+
+}}
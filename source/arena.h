@@ -0,0 +1,29 @@
+#pragma once
+
+#include "MicroBitImage.h"
+
+#include <cstdint>
+
+namespace maze { namespace arena {
+
+// One static image buffer per use, so the game images never touch the heap
+enum Slot {
+  SlotScreen = 0, SlotMap, SlotTitle, SlotIcon, SlotCount
+};
+
+// Pixels per slot, enough for the largest icon
+uint16_t constexpr sSlotPixels = 7 * 5;
+
+// Panic code if an image does not fit into its slot
+int constexpr sPanicTooLarge = 71;
+
+// Image backed by the slot, the pixels are copied in if given.
+// The image data is never freed, any older image of the slot shows the
+// new content. Panics if width x height exceeds the slot.
+MicroBitImage image (Slot slot, uint16_t width, uint16_t height, uint8_t const* pixels = nullptr);
+
+// Slots handed out so far and their pixel bytes
+uint8_t used ();
+uint16_t usedBytes ();
+
+}}
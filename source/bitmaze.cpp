@@ -0,0 +1,59 @@
+#include "bitmaze.h"
+
+#include <algorithm>
+
+namespace maze
+{
+
+BitMaze::BitMaze (int32_t const width, int32_t const height)
+{
+  resize (width, height);
+}
+
+void BitMaze::resize (int32_t const width, int32_t const height)
+{
+  mWidth = width;
+  mHeight = height;
+  mStride = (width + 31) / 32;
+  mBits.assign (static_cast<size_t> (LayerCount) * height * mStride, 0u);
+}
+
+void BitMaze::assign (uint8_t const* tiles, int32_t const width, int32_t const height)
+{
+  resize (width, height);
+  for (int32_t y = 0; y < height; ++y)
+    for (int32_t x = 0; x < width; ++x)
+      setTile (x, y, tiles [y * width + x]);
+}
+
+void BitMaze::assignBits (uint32_t const* bits, int32_t const width, int32_t const height)
+{
+  resize (width, height);
+  std::copy (bits, bits + mBits.size (), mBits.begin ());
+}
+
+uint8_t BitMaze::tile (int32_t const x, int32_t const y) const
+{
+  if (test (LayerBlocking, x, y))
+    return 9;
+  if (test (LayerVisible, x, y))
+    return 8;
+  if (test (LayerTrap, x, y))
+    return 1;
+  if (test (LayerDark, x, y))
+    return 2;
+  if (test (LayerTwister, x, y))
+    return 3;
+  return 0;
+}
+
+void BitMaze::setTile (int32_t const x, int32_t const y, uint8_t const tile)
+{
+  set (LayerBlocking, x, y, tileInLayer (LayerBlocking, tile));
+  set (LayerVisible, x, y, tileInLayer (LayerVisible, tile));
+  set (LayerTrap, x, y, tileInLayer (LayerTrap, tile));
+  set (LayerDark, x, y, tileInLayer (LayerDark, tile));
+  set (LayerTwister, x, y, tileInLayer (LayerTwister, tile));
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace maze
+{
+
+// One bit per cell for each class of tile
+//
+// tile to layer mapping:
+// 9: blocking + visible
+// 8: visible
+// 0: -
+// 1: trap
+// 2: dark
+// 3: twister
+//
+enum Layer {
+  LayerBlocking = 0,
+  LayerVisible,
+  LayerTrap,
+  LayerDark,
+  LayerTwister,
+  LayerCount
+};
+
+// Whether a tile value sets the bit of a layer
+constexpr bool tileInLayer (Layer const layer, uint8_t const tile)
+{
+  return (LayerBlocking == layer) ? 8 < tile
+       : (LayerVisible == layer) ? 4 < tile
+       : (LayerTrap == layer) ? 1 == tile
+       : (LayerDark == layer) ? 2 == tile
+       : (LayerTwister == layer) ? 3 == tile
+       : false;
+}
+
+// Bit packed maze, row y, column x.
+// Each layer row is stored as 32 bit words, bit (x % 32) of word (x / 32).
+// All layers share one buffer so a maze costs one allocation.
+class BitMaze
+{
+public:
+  BitMaze () = default;
+  BitMaze (int32_t width, int32_t height);
+
+  // Clears all layers
+  void resize (int32_t width, int32_t height);
+
+  // Fills the maze from row major tile values
+  void assign (uint8_t const* tiles, int32_t width, int32_t height);
+
+  // Copies layer words laid out like the own buffer, e.g. precomputed ones
+  void assignBits (uint32_t const* bits, int32_t width, int32_t height);
+
+  int32_t width () const { return mWidth; }
+  int32_t height () const { return mHeight; }
+  // 32 bit words per layer row
+  int32_t stride () const { return mStride; }
+
+  bool test (Layer const layer, int32_t const x, int32_t const y) const
+  {
+    return (mBits [index (layer, y) + (x >> 5)] >> (x & 31)) & 1u;
+  }
+
+  void set (Layer const layer, int32_t const x, int32_t const y, bool const value)
+  {
+    auto& word = mBits [index (layer, y) + (x >> 5)];
+    auto const mask = 1u << (x & 31);
+    word = value ? (word | mask) : (word & ~mask);
+  }
+
+  uint32_t const* row (Layer const layer, int32_t const y) const
+  {
+    return &mBits [index (layer, y)];
+  }
+
+  uint32_t* row (Layer const layer, int32_t const y)
+  {
+    return &mBits [index (layer, y)];
+  }
+
+  // Tile value as used in the level definitions
+  uint8_t tile (int32_t x, int32_t y) const;
+  void setTile (int32_t x, int32_t y, uint8_t tile);
+
+private:
+  size_t index (Layer const layer, int32_t const y) const
+  {
+    return (static_cast<size_t> (layer) * mHeight + y) * mStride;
+  }
+
+  int32_t mWidth = 0;
+  int32_t mHeight = 0;
+  int32_t mStride = 0;
+  std::vector<uint32_t> mBits;
+};
+
+}
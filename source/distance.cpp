@@ -0,0 +1,212 @@
+#include "distance.h"
+
+#include <algorithm>
+
+namespace maze
+{
+
+namespace
+{
+
+// saturate instead of wrapping on huge mazes
+uint16_t step (uint16_t const distance)
+{
+  return (distance < sUnreachable - 1) ? distance + 1 : distance;
+}
+
+}
+
+void DistanceField::compute (BitMaze const& maze, int32_t const goalX, int32_t const goalY)
+{
+  auto const width = maze.width ();
+  auto const height = maze.height ();
+  auto const size = static_cast<size_t> (width) * height;
+
+  mWidth = width;
+  mHeight = height;
+  mGoal = static_cast<uint32_t> (goalY * width + goalX);
+  mMaximum = 0;
+  mDistance.assign (size, sUnreachable);
+
+  // Every cell is queued at most once
+  std::vector<uint32_t> queue;
+  queue.reserve (size);
+
+  mDistance [goalY * width + goalX] = 0;
+  queue.push_back (goalY * width + goalX);
+
+  for (size_t head = 0; head < queue.size (); ++head)
+  {
+    auto const index = queue [head];
+    int32_t const x = index % width;
+    int32_t const y = index / width;
+    auto const distance = mDistance [index];
+    if (distance > mMaximum)
+      mMaximum = distance;
+
+    // traps are sinks
+    if (maze.test (LayerTrap, x, y))
+      continue;
+
+    auto const next = step (distance);
+
+    int32_t const neighbours [4][2] = {
+      {x, y - 1}, {x + 1, y}, {x, y + 1}, {x - 1, y}
+    };
+    for (auto const& n : neighbours)
+    {
+      if (n [0] < 0 || n [1] < 0 || n [0] >= width || n [1] >= height)
+        continue;
+      auto const nIndex = n [1] * width + n [0];
+      if (sUnreachable != mDistance [nIndex] ||
+          maze.test (LayerBlocking, n [0], n [1]))
+        continue;
+      mDistance [nIndex] = next;
+      queue.push_back (nIndex);
+    }
+  }
+}
+
+bool DistanceField::spreads (BitMaze const& maze, uint32_t const index) const
+{
+  // traps are sinks
+  return sUnreachable != mDistance [index] &&
+         !maze.test (LayerTrap, static_cast<int32_t> (index % mWidth), static_cast<int32_t> (index / mWidth));
+}
+
+void DistanceField::rescanMaximum ()
+{
+  mMaximum = 0;
+  for (auto const distance : mDistance)
+    if (sUnreachable != distance && distance > mMaximum)
+      mMaximum = distance;
+}
+
+void DistanceField::update (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  auto const width = mWidth;
+  auto const height = mHeight;
+  auto const changed = static_cast<uint32_t> (y * width + x);
+  if (changed == mGoal)
+    return;
+
+  // the cells next to index inside the maze
+  auto const neighbours = [width, height] (uint32_t const index, uint32_t (&cells) [4]) {
+    int32_t const cx = index % width;
+    int32_t const cy = index / width;
+    uint8_t count = 0;
+    if (cy > 0)
+      cells [count++] = index - width;
+    if (cx < width - 1)
+      cells [count++] = index + 1;
+    if (cy < height - 1)
+      cells [count++] = index + width;
+    if (cx > 0)
+      cells [count++] = index - 1;
+    return count;
+  };
+
+  auto const oldMaximum = mMaximum;
+  bool lostMaximum = false;
+  uint16_t raised = 0;
+  uint32_t cells [4];
+
+  mQueue.clear ();
+  mLost.clear ();
+  mSeeds.clear ();
+
+  // The changed cell loses its distance, then every cell one step
+  // farther that has no other neighbour one step nearer, level by level
+  mLost.push_back (changed);
+  if (sUnreachable != mDistance [changed])
+  {
+    lostMaximum = mDistance [changed] == oldMaximum;
+    auto const next = step (mDistance [changed]);
+    mDistance [changed] = sUnreachable;
+    for (uint8_t i = 0, n = neighbours (changed, cells); i < n; ++i)
+      if (next == mDistance [cells [i]])
+        mQueue.push_back (cells [i]);
+  }
+
+  for (size_t head = 0; head < mQueue.size (); ++head)
+  {
+    auto const index = mQueue [head];
+    auto const distance = mDistance [index];
+    if (sUnreachable == distance || index == mGoal)
+      continue;
+
+    bool kept = false;
+    auto const n = neighbours (index, cells);
+    for (uint8_t i = 0; i < n && !kept; ++i)
+      kept = spreads (maze, cells [i]) && step (mDistance [cells [i]]) == distance;
+    if (kept)
+      continue;
+
+    lostMaximum = lostMaximum || distance == oldMaximum;
+    mDistance [index] = sUnreachable;
+    mLost.push_back (index);
+    for (uint8_t i = 0; i < n; ++i)
+      if (step (distance) == mDistance [cells [i]])
+        mQueue.push_back (cells [i]);
+  }
+
+  // Seeds from the neighbours that kept their distance, nearest first
+  for (auto const index : mLost)
+  {
+    if (maze.test (LayerBlocking, static_cast<int32_t> (index % width), static_cast<int32_t> (index / width)))
+      continue;
+    auto best = sUnreachable;
+    for (uint8_t i = 0, n = neighbours (index, cells); i < n; ++i)
+      if (spreads (maze, cells [i]))
+        best = std::min (best, step (mDistance [cells [i]]));
+    if (sUnreachable != best)
+      mSeeds.emplace_back (best, index);
+  }
+  std::sort (mSeeds.begin (), mSeeds.end ());
+
+  // Breadth first search merged with the sorted seeds, so the cells are
+  // taken nearest first as in a priority queue
+  mQueue.clear ();
+  size_t head = 0;
+  size_t seed = 0;
+  while (head < mQueue.size () || seed < mSeeds.size ())
+  {
+    uint32_t index;
+    if (seed < mSeeds.size () &&
+        (head == mQueue.size () || mSeeds [seed].first < mDistance [mQueue [head]]))
+    {
+      auto const& next = mSeeds [seed++];
+      if (next.first >= mDistance [next.second])
+        continue;
+      index = next.second;
+      mDistance [index] = next.first;
+      raised = std::max (raised, next.first);
+    }
+    else
+      index = mQueue [head++];
+
+    if (!spreads (maze, index))
+      continue;
+
+    auto const next = step (mDistance [index]);
+    for (uint8_t i = 0, n = neighbours (index, cells); i < n; ++i)
+    {
+      auto const cell = cells [i];
+      if (mDistance [cell] <= next ||
+          maze.test (LayerBlocking, static_cast<int32_t> (cell % width), static_cast<int32_t> (cell / width)))
+        continue;
+      lostMaximum = lostMaximum || mDistance [cell] == oldMaximum;
+      mDistance [cell] = next;
+      raised = std::max (raised, next);
+      mQueue.push_back (cell);
+    }
+  }
+
+  // Only when the farthest cells got nearer all cells are looked at
+  if (raised >= oldMaximum)
+    mMaximum = raised;
+  else if (lostMaximum)
+    rescanMaximum ();
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "bitmaze.h"
+
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace maze
+{
+
+uint16_t constexpr sUnreachable = 0xffff;
+
+// Shortest path distance of every cell to a goal cell, row y, column x.
+// Computed by breadth first search over the non blocking cells:
+// secret walls are passable, traps get a distance but are never
+// walked through.
+class DistanceField
+{
+public:
+  void compute (BitMaze const& maze, int32_t goalX, int32_t goalY);
+
+  // Repairs the field after the tiles of cell (x, y) changed, e.g. a door
+  // opened. Like LPA* for steps of one: the cells whose distance came
+  // through the cell lose it, the lost cells and the cell itself are
+  // seeded from their neighbours that kept theirs, and a search from the
+  // seeds lowers every cell that got nearer. Only the changed region is
+  // visited. The goal itself must not change.
+  void update (BitMaze const& maze, int32_t x, int32_t y);
+
+  uint16_t at (int32_t const x, int32_t const y) const
+  {
+    return mDistance [y * mWidth + x];
+  }
+
+  // Largest reachable distance, 0 if only the goal is reachable
+  uint16_t maximum () const { return mMaximum; }
+
+private:
+  // Whether a cell passes its distance on to its neighbours
+  bool spreads (BitMaze const& maze, uint32_t index) const;
+  void rescanMaximum ();
+
+  int32_t mWidth = 0;
+  int32_t mHeight = 0;
+  uint32_t mGoal = 0;
+  uint16_t mMaximum = 0;
+  std::vector<uint16_t> mDistance;
+
+  // scratch of update, kept to not allocate on every change
+  std::vector<uint32_t> mQueue;
+  std::vector<uint32_t> mLost;
+  std::vector<std::pair<uint16_t, uint32_t>> mSeeds;
+};
+
+}
@@ -0,0 +1,14 @@
+#include "explored.h"
+
+namespace maze
+{
+
+void Explored::reset (int32_t const width, int32_t const height)
+{
+  mWidth = width;
+  mHeight = height;
+  mStride = (width + 31) / 32;
+  mBits.assign (static_cast<size_t> (height) * mStride, 0u);
+}
+
+}
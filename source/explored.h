@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace maze
+{
+
+// Cells the player has seen, one bit per cell, rows of 32 bit words as a
+// BitMaze layer. A 64 x 64 level takes 512 bytes.
+class Explored
+{
+public:
+  // Forgets all cells
+  void reset (int32_t width, int32_t height);
+
+  int32_t width () const { return mWidth; }
+  int32_t height () const { return mHeight; }
+  // the rows of bits as they are saved
+  size_t words () const { return mBits.size (); }
+  uint32_t const* data () const { return mBits.data (); }
+  uint32_t* data () { return mBits.data (); }
+
+  // Cells outside are never seen
+  bool test (int32_t const x, int32_t const y) const
+  {
+    return inside (x, y) && ((mBits [index (x, y)] >> (x & 31)) & 1u);
+  }
+
+  void mark (int32_t const x, int32_t const y)
+  {
+    if (inside (x, y))
+      mBits [index (x, y)] |= 1u << (x & 31);
+  }
+
+private:
+  bool inside (int32_t const x, int32_t const y) const
+  {
+    return x >= 0 && y >= 0 && x < mWidth && y < mHeight;
+  }
+
+  size_t index (int32_t const x, int32_t const y) const
+  {
+    return static_cast<size_t> (y) * mStride + (x >> 5);
+  }
+
+  int32_t mWidth = 0;
+  int32_t mHeight = 0;
+  int32_t mStride = 0;
+  std::vector<uint32_t> mBits;
+};
+
+}
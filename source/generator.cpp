@@ -0,0 +1,243 @@
+#include "generator.h"
+
+namespace maze
+{
+
+namespace
+{
+
+// Steps of two cells per direction, indexed like Direction
+int32_t constexpr sDx [4] = {0, 1, 0, -1};
+int32_t constexpr sDy [4] = {-1, 0, 1, 0};
+
+// xorshift32, state must not be 0
+uint32_t nextRandom (uint32_t& state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+uint32_t random (uint32_t& state, uint32_t const max)
+{
+  return nextRandom (state) % max;
+}
+
+bool chance (uint32_t& state, uint16_t const perMille)
+{
+  return random (state, 1000) < perMille;
+}
+
+bool isCell (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  return x > 0 && y > 0 && x < maze.width () - 1 && y < maze.height () - 1;
+}
+
+bool isCarved (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  return !maze.test (LayerBlocking, x, y);
+}
+
+void carve (BitMaze& maze, int32_t const x, int32_t const y)
+{
+  maze.set (LayerBlocking, x, y, false);
+  maze.set (LayerVisible, x, y, false);
+}
+
+// 2 bit direction scratch per cell
+void setScratch (BitMaze& maze, int32_t const x, int32_t const y, int const di)
+{
+  maze.set (LayerTrap, x, y, di & 1);
+  maze.set (LayerDark, x, y, di & 2);
+}
+
+int getScratch (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  return (maze.test (LayerTrap, x, y) ? 1 : 0) | (maze.test (LayerDark, x, y) ? 2 : 0);
+}
+
+void clearScratch (BitMaze& maze)
+{
+  for (int32_t y = 0; y < maze.height (); ++y)
+    for (int32_t w = 0; w < maze.stride (); ++w)
+    {
+      maze.row (LayerTrap, y) [w] = 0u;
+      maze.row (LayerDark, y) [w] = 0u;
+    }
+}
+
+void backtracker (BitMaze& maze, uint32_t& state, int32_t const sx, int32_t const sy)
+{
+  auto x = sx;
+  auto y = sy;
+  carve (maze, x, y);
+
+  for (;;)
+  {
+    // collect uncarved neighbours
+    int candidates [4];
+    int count = 0;
+    for (int di = 0; di < 4; ++di)
+    {
+      auto const nx = x + 2 * sDx [di];
+      auto const ny = y + 2 * sDy [di];
+      if (isCell (maze, nx, ny) && !isCarved (maze, nx, ny))
+        candidates [count++] = di;
+    }
+
+    if (count > 0)
+    {
+      auto const di = candidates [random (state, count)];
+      carve (maze, x + sDx [di], y + sDy [di]);
+      x += 2 * sDx [di];
+      y += 2 * sDy [di];
+      carve (maze, x, y);
+      // remember the way back
+      setScratch (maze, x, y, (di + 2) & 3);
+      continue;
+    }
+
+    if (x == sx && y == sy)
+      break;
+
+    auto const back = getScratch (maze, x, y);
+    x += 2 * sDx [back];
+    y += 2 * sDy [back];
+  }
+}
+
+void wilson (BitMaze& maze, uint32_t& state, int32_t const sx, int32_t const sy)
+{
+  carve (maze, sx, sy);
+
+  for (int32_t y0 = 1; y0 < maze.height () - 1; y0 += 2)
+    for (int32_t x0 = 1; x0 < maze.width () - 1; x0 += 2)
+    {
+      if (isCarved (maze, x0, y0))
+        continue;
+
+      // random walk until the tree is hit, the last exit of each cell
+      // wins which erases the loops
+      auto x = x0;
+      auto y = y0;
+      while (!isCarved (maze, x, y))
+      {
+        int di;
+        do
+        {
+          di = random (state, 4);
+        }
+        while (!isCell (maze, x + 2 * sDx [di], y + 2 * sDy [di]));
+        setScratch (maze, x, y, di);
+        x += 2 * sDx [di];
+        y += 2 * sDy [di];
+      }
+
+      // add the loop erased walk to the tree
+      x = x0;
+      y = y0;
+      while (!isCarved (maze, x, y))
+      {
+        auto const di = getScratch (maze, x, y);
+        carve (maze, x, y);
+        carve (maze, x + sDx [di], y + sDy [di]);
+        x += 2 * sDx [di];
+        y += 2 * sDy [di];
+      }
+    }
+}
+
+int openSides (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  int count = 0;
+  for (int di = 0; di < 4; ++di)
+    if (isCarved (maze, x + sDx [di], y + sDy [di]))
+      ++count;
+  return count;
+}
+
+void placeTiles (BitMaze& maze, uint32_t& state, GeneratorConfig const& config, Endpoints const& ends)
+{
+  for (int32_t y = 1; y < maze.height () - 1; y += 2)
+    for (int32_t x = 1; x < maze.width () - 1; x += 2)
+    {
+      if ((x == ends.sx && y == ends.sy) || (x == ends.ex && y == ends.ey))
+        continue;
+
+      if (1 == openSides (maze, x, y))
+      {
+        if (chance (state, config.traps))
+          maze.setTile (x, y, 1);
+      }
+      else if (chance (state, config.twisters))
+        maze.setTile (x, y, 3);
+      else if (chance (state, config.dark))
+        maze.setTile (x, y, 2);
+    }
+
+  // secret walls between two cells, never next to a trap so dead ends stay dead ends
+  for (int32_t y = 1; y < maze.height () - 1; ++y)
+    for (int32_t x = 1 + (y & 1); x < maze.width () - 1; x += 2)
+    {
+      if (isCarved (maze, x, y))
+        continue;
+
+      auto const horizontal = (y & 1) != 0;
+      auto const ax = horizontal ? x - 1 : x;
+      auto const ay = horizontal ? y : y - 1;
+      auto const bx = horizontal ? x + 1 : x;
+      auto const by = horizontal ? y : y + 1;
+      if (!maze.test (LayerTrap, ax, ay) &&
+          !maze.test (LayerTrap, bx, by) &&
+          chance (state, config.secretWalls))
+        maze.setTile (x, y, 8);
+    }
+}
+
+}
+
+Endpoints generate (BitMaze& maze, DistanceField& scratch, GeneratorConfig const& config)
+{
+  auto const width = (config.width < 5) ? 5 : (config.width - 1) | 1;
+  auto const height = (config.height < 5) ? 5 : (config.height - 1) | 1;
+
+  maze.resize (width, height);
+  for (int32_t y = 0; y < height; ++y)
+    for (int32_t x = 0; x < width; ++x)
+      maze.setTile (x, y, 9);
+
+  uint32_t state = config.seed ? config.seed : 0x9e3779b9u;
+
+  Endpoints ends;
+  ends.sx = 1 + 2 * random (state, (width - 1) / 2);
+  ends.sy = 1 + 2 * random (state, (height - 1) / 2);
+
+  switch (config.algorithm)
+  {
+  case RecursiveBacktracker:
+    backtracker (maze, state, ends.sx, ends.sy);
+    break;
+  case Wilson:
+    wilson (maze, state, ends.sx, ends.sy);
+    break;
+  }
+  clearScratch (maze);
+
+  // farthest cell from the start
+  scratch.compute (maze, ends.sx, ends.sy);
+  ends.ex = ends.sx;
+  ends.ey = ends.sy;
+  for (int32_t y = 1; y < height - 1; y += 2)
+    for (int32_t x = 1; x < width - 1; x += 2)
+      if (scratch.maximum () == scratch.at (x, y))
+      {
+        ends.ex = x;
+        ends.ey = y;
+      }
+
+  placeTiles (maze, state, config, ends);
+  return ends;
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "bitmaze.h"
+#include "distance.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+enum Algorithm {
+  RecursiveBacktracker = 0, Wilson
+};
+
+struct GeneratorConfig {
+  uint32_t seed = 1;
+  // odd sizes including the border, smaller sizes are rounded down
+  int32_t width = 13;
+  int32_t height = 13;
+  Algorithm algorithm = RecursiveBacktracker;
+
+  // densities in per mille
+  // traps: of the dead ends
+  uint16_t traps = 300;
+  // dark floors and twisters: of the floor cells
+  uint16_t dark = 60;
+  uint16_t twisters = 30;
+  // secret walls: of the walls between two floor cells
+  uint16_t secretWalls = 40;
+};
+
+struct Endpoints {
+  int32_t sx = 1;
+  int32_t sy = 1;
+  int32_t ex = 1;
+  int32_t ey = 1;
+};
+
+// Generates a perfect maze into the given maze, then places start, end
+// and special tiles. The start is random, the end is the cell farthest
+// away from it. Runs in place: the trap and dark layers serve as 2 bit
+// scratch per cell while carving, the distance field is only used to
+// find the end and can be reused by the caller afterwards.
+Endpoints generate (BitMaze& maze, DistanceField& scratch, GeneratorConfig const& config);
+
+}
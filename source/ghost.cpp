@@ -0,0 +1,267 @@
+#include "ghost.h"
+
+namespace maze { namespace ghost {
+
+namespace
+{
+
+// Steps per direction, North means looking to row zero
+int8_t constexpr sDx [4] = {0, 1, 0, -1};
+int8_t constexpr sDy [4] = {-1, 0, 1, 0};
+
+uint8_t event (uint8_t const di, uint8_t const steps)
+{
+  return static_cast<uint8_t> ((di & 3) | (steps << 2));
+}
+
+uint8_t steps (uint8_t const event)
+{
+  return event >> 2;
+}
+
+uint16_t read16 (uint8_t const* data)
+{
+  return static_cast<uint16_t> (data [0] | (data [1] << 8));
+}
+
+void write16 (uint8_t* data, uint32_t const value)
+{
+  data [0] = static_cast<uint8_t> (value);
+  data [1] = static_cast<uint8_t> (value >> 8);
+}
+
+}
+
+void Race::start (Transport* const transport, uint16_t const id, uint16_t const level,
+                  Position const& self, uint32_t const now)
+{
+  mTransport = transport;
+  mId = id;
+  mLevel = level;
+  mSelf = self;
+  mEventCount = 0;
+  mSplit = 0;
+  mMoved = false;
+  // announce the player right away
+  mKeyDue = true;
+  mLastSend = now;
+  mLastKey = now;
+  for (auto& ghost : mGhosts)
+    ghost = Ghost ();
+  mStats = Stats ();
+}
+
+void Race::push (uint8_t const event)
+{
+  if (mKeyDue)
+    return;
+  if (sMaxEvents == mEventCount)
+  {
+    mKeyDue = true;
+    return;
+  }
+  mEvents [mEventCount++] = event;
+}
+
+void Race::turn (uint8_t const di)
+{
+  if (!started ())
+    return;
+
+  mSelf.di = di & 3;
+  mMoved = true;
+  // a turn after a turn since the last key replaces it
+  if (mEventCount > mSplit && 0 == steps (mEvents [mEventCount - 1]))
+    mEvents [mEventCount - 1] = event (di, 0);
+  else
+    push (event (di, 0));
+}
+
+void Race::step (uint8_t const moveDi, uint8_t const di)
+{
+  if (!started ())
+    return;
+
+  mSelf.px += sDx [moveDi & 3];
+  mSelf.py += sDy [moveDi & 3];
+  mSelf.di = di & 3;
+  mMoved = true;
+
+  // a step straight on extends the last event since the last key
+  auto* last = (mEventCount > mSplit) ? &mEvents [mEventCount - 1] : nullptr;
+  if (last && (moveDi & 3) == (*last & 3) && steps (*last) < sMaxSteps)
+    *last = event (moveDi, steps (*last) + 1);
+  else
+    push (event (moveDi, 1));
+
+  // a twister turned the player
+  if ((di & 3) != (moveDi & 3))
+    push (event (di, 0));
+}
+
+void Race::end (uint8_t const end)
+{
+  mSelf.end = end;
+  mKeyDue = true;
+}
+
+void Race::header (uint8_t* const data, uint8_t const kind)
+{
+  data [0] = static_cast<uint8_t> ((sVersion << 4) | kind);
+  write16 (data + 1, mId);
+  data [3] = mSequence++;
+  write16 (data + 4, mLevel);
+}
+
+bool Race::send (uint32_t const now)
+{
+  if (!started ())
+    return false;
+
+  uint8_t data [sPacketSize];
+  if (mKeyDue || now - mLastKey >= sKeyInterval)
+  {
+    // the key holds all moves so far
+    mKeys [0] = (0 == mStats.keys) ? mSequence : mKeys [1];
+    mKeys [1] = mSequence;
+    header (data, sKindKey);
+    write16 (data + sHeaderSize, static_cast<uint32_t> (mSelf.px));
+    write16 (data + sHeaderSize + 2, static_cast<uint32_t> (mSelf.py));
+    data [sHeaderSize + 4] = static_cast<uint8_t> ((mSelf.end << 2) | (mSelf.di & 3));
+    mTransport->send (data, sKeySize);
+
+    // only the moves since the last key are kept
+    for (uint8_t i = mSplit; i < mEventCount; ++i)
+      mEvents [i - mSplit] = mEvents [i];
+    mEventCount = static_cast<uint8_t> (mEventCount - mSplit);
+    mSplit = mEventCount;
+    mKeyDue = false;
+    mMoved = false;
+    mLastKey = now;
+    mLastSend = now;
+    mStats.keys += 1;
+    mStats.bytes += sKeySize;
+    return true;
+  }
+
+  if (!mMoved || now - mLastSend < sBatchInterval)
+    return false;
+
+  header (data, sKindDelta);
+  data [sHeaderSize] = mKeys [0];
+  data [sHeaderSize + 1] = mKeys [1];
+  data [sHeaderSize + 2] = mSplit;
+  for (uint8_t i = 0; i < mEventCount; ++i)
+    data [sDeltaHeaderSize + i] = mEvents [i];
+  auto const size = static_cast<uint8_t> (sDeltaHeaderSize + mEventCount);
+  mTransport->send (data, size);
+
+  mMoved = false;
+  mLastSend = now;
+  mStats.deltas += 1;
+  mStats.bytes += size;
+  return true;
+}
+
+bool Race::apply (uint8_t const* const data, uint8_t const size, uint32_t const now)
+{
+  if (size < sHeaderSize || sVersion != (data [0] >> 4))
+    return false;
+
+  auto const kind = data [0] & 0xf;
+  auto const id = read16 (data + 1);
+  auto const sequence = data [3];
+  if (id == mId || read16 (data + 4) != mLevel)
+    return false;
+  mStats.received += 1;
+
+  Ghost* ghost = nullptr;
+  Ghost* free = nullptr;
+  for (auto& other : mGhosts)
+  {
+    if (other.active && other.id == id)
+      ghost = &other;
+    else if (!other.active && !free)
+      free = &other;
+  }
+
+  if (!ghost && sKindKey == kind && size >= sKeySize)
+  {
+    // more players than ghost slots, the others stay unseen
+    if (!free)
+      return false;
+    ghost = free;
+    ghost->active = true;
+    ghost->id = id;
+    ghost->sequence = static_cast<uint8_t> (sequence - 1);
+  }
+  if (!ghost)
+    return false;
+
+  // the radio keeps the order, older packets are repeated ones
+  auto const ahead = static_cast<int8_t> (sequence - ghost->sequence);
+  if (ahead <= 0)
+    return false;
+  mStats.gaps += ahead - 1;
+  ghost->sequence = sequence;
+  ghost->heard = now;
+
+  if (sKindKey == kind && size >= sKeySize)
+  {
+    ghost->key = sequence;
+    auto& key = ghost->keyPosition;
+    key.px = read16 (data + sHeaderSize);
+    key.py = read16 (data + sHeaderSize + 2);
+    key.di = data [sHeaderSize + 4] & 3;
+    key.end = data [sHeaderSize + 4] >> 2;
+    ghost->position = key;
+    return true;
+  }
+
+  if (sKindDelta != kind || size < sDeltaHeaderSize)
+    return false;
+
+  // the moves since the key the ghost has, both keys may be lost
+  uint8_t first = sDeltaHeaderSize;
+  if (data [sHeaderSize + 1] == ghost->key)
+    first = static_cast<uint8_t> (first + data [sHeaderSize + 2]);
+  else if (data [sHeaderSize] != ghost->key)
+    return false;
+
+  auto& position = ghost->position;
+  position = ghost->keyPosition;
+  for (uint8_t i = first; i < size; ++i)
+  {
+    position.di = data [i] & 3;
+    position.px += sDx [position.di] * steps (data [i]);
+    position.py += sDy [position.di] * steps (data [i]);
+  }
+  return true;
+}
+
+bool Race::receive (uint32_t const now)
+{
+  if (!started ())
+    return false;
+
+  bool changed = false;
+  uint8_t data [sPacketSize];
+  for (auto size = mTransport->receive (data, sizeof (data)); 0 != size;
+       size = mTransport->receive (data, sizeof (data)))
+    changed = apply (data, size, now) || changed;
+  return changed;
+}
+
+bool Race::expire (uint32_t const now)
+{
+  bool changed = false;
+  for (auto& ghost : mGhosts)
+    if (ghost.active && now - ghost.heard > sTimeout)
+    {
+      ghost.active = false;
+      changed = true;
+    }
+  return changed;
+}
+
+}}
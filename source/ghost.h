@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+
+namespace maze { namespace ghost {
+
+// Packets of the ghost race, all numbers little endian:
+//
+// header: u8 version << 4 | kind, u16 player id, u8 sequence, u16 level id
+// key:    u16 px, u16 py, u8 end << 2 | di
+// delta:  u8 sequence of the key before the last, u8 sequence of the last
+//         key, u8 first event after the last key, then one event per byte
+//         up to the end of the packet: bits 0 - 1 turn to this direction,
+//         bits 2 - 7 then walk that many cells
+//
+// Every packet counts up the sequence of its player. A delta holds all
+// moves since the key before the last, so any delta puts the ghost in
+// place again as long as one of the two keys was received. Else the ghost
+// stays at its last known position until the next key.
+uint8_t constexpr sVersion = 1;
+uint8_t constexpr sKindKey = 1;
+uint8_t constexpr sKindDelta = 2;
+// largest radio datagram
+uint8_t constexpr sPacketSize = 32;
+uint8_t constexpr sHeaderSize = 6;
+uint8_t constexpr sKeySize = sHeaderSize + 5;
+uint8_t constexpr sDeltaHeaderSize = sHeaderSize + 3;
+uint8_t constexpr sMaxEvents = sPacketSize - sDeltaHeaderSize;
+uint8_t constexpr sMaxSteps = 63;
+
+uint8_t constexpr sMaxGhosts = 4;
+// moves are collected this long into one delta
+uint32_t constexpr sBatchInterval = 100ul /*ms*/;
+// a key packet at least this often, for lost deltas and late joiners
+uint32_t constexpr sKeyInterval = 1000ul /*ms*/;
+// ghosts not heard of this long are dropped
+uint32_t constexpr sTimeout = 5000ul /*ms*/;
+
+// Sends and receives whole packets, may lose some of them
+class Transport
+{
+public:
+  virtual ~Transport () = default;
+
+  virtual void send (uint8_t const* data, uint8_t size) = 0;
+
+  // Copies the next received packet into data, 0 if there is none
+  virtual uint8_t receive (uint8_t* data, uint8_t capacity) = 0;
+};
+
+struct Position {
+  int32_t px = 0;
+  int32_t py = 0;
+  uint8_t di = 0;
+  // 0: playing, 1: victory, 2: death
+  uint8_t end = 0;
+};
+
+struct Ghost {
+  bool active = false;
+  uint16_t id = 0;
+  // the deltas of this key apply
+  uint8_t key = 0;
+  // last packet read
+  uint8_t sequence = 0;
+  uint32_t heard = 0;
+  Position keyPosition;
+  Position position;
+};
+
+// Shares the own position with the other players of the same level and
+// follows theirs. The move calls only append to the events since the last
+// key, the packets go out in send.
+class Race
+{
+public:
+  struct Stats {
+    uint32_t keys = 0;
+    uint32_t deltas = 0;
+    uint32_t bytes = 0;
+    uint32_t received = 0;
+    // packets of others missed
+    uint32_t gaps = 0;
+  };
+
+  void start (Transport* transport, uint16_t id, uint16_t level, Position const& self, uint32_t now);
+
+  bool started () const { return nullptr != mTransport; }
+
+  void turn (uint8_t di);
+  // A step into moveDi, facing di afterwards
+  void step (uint8_t moveDi, uint8_t di);
+  // The end of the game goes out with the next send
+  void end (uint8_t end);
+
+  // Sends a key packet if due, else a delta if there are new moves and
+  // the last packet is sBatchInterval old. True if a packet went out.
+  bool send (uint32_t now);
+
+  // Reads all received packets, true if a ghost moved or appeared
+  bool receive (uint32_t now);
+
+  // Drops the ghosts not heard of for sTimeout, true if any
+  bool expire (uint32_t now);
+
+  Ghost const* ghosts () const { return mGhosts; }
+  Position const& self () const { return mSelf; }
+  Stats const& stats () const { return mStats; }
+
+private:
+  void push (uint8_t event);
+  void header (uint8_t* data, uint8_t kind);
+  bool apply (uint8_t const* data, uint8_t size, uint32_t now);
+
+  Transport* mTransport = nullptr;
+  uint16_t mId = 0;
+  uint16_t mLevel = 0;
+  uint8_t mSequence = 0;
+  // sequences of the key before the last and of the last one
+  uint8_t mKeys [2] = {0, 0};
+
+  Position mSelf;
+  // moves since the key before the last, the ones since the last key
+  // start at mSplit
+  uint8_t mEvents [sMaxEvents];
+  uint8_t mEventCount = 0;
+  uint8_t mSplit = 0;
+  // moves not sent yet
+  bool mMoved = false;
+  // the events do not fit into one delta, a key packet follows instead
+  bool mKeyDue = false;
+  uint32_t mLastSend = 0;
+  uint32_t mLastKey = 0;
+
+  Ghost mGhosts [sMaxGhosts];
+  Stats mStats;
+};
+
+}}
@@ -0,0 +1,273 @@
+#include "heap.h"
+#include "arena.h"
+
+#include <MicroBit.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+extern MicroBit uBit;
+
+namespace maze { namespace heap {
+
+namespace
+{
+
+struct Site {
+  size_t current = 0;
+  size_t peak = 0;
+  uint32_t allocations = 0;
+  uint32_t frees = 0;
+};
+
+// In front of every block, padded so the block keeps the alignment of
+// malloc
+struct Header {
+  size_t bytes;
+  Tag tag;
+};
+size_t constexpr sHeaderSize =
+  (sizeof (Header) + alignof (std::max_align_t) - 1) / alignof (std::max_align_t) * alignof (std::max_align_t);
+
+// Live blocks whose gaps tell the fragmentation, the game holds far
+// fewer at once. Blocks beyond are counted but not placed.
+size_t constexpr sMaxBlocks = 32;
+
+struct Block {
+  uintptr_t address;
+  size_t bytes;
+};
+
+Site sSites [TagCount];
+size_t sCurrent = 0;
+size_t sPeak = 0;
+Tag sTag = TagOther;
+
+Block sBlocks [sMaxBlocks];
+size_t sBlockCount = 0;
+uint32_t sUnplaced = 0;
+
+char const* const sNames [TagCount] = {
+  "other", "level", "distance", "explored", "validate"
+};
+
+// Allocations also come from interrupts, the counts change with them off
+class Lock
+{
+public:
+  Lock ()
+    : mMask (__get_PRIMASK ())
+  {
+    __disable_irq ();
+  }
+
+  ~Lock ()
+  {
+    __set_PRIMASK (mMask);
+  }
+
+private:
+  uint32_t mMask;
+};
+
+void place (uintptr_t const address, size_t const bytes)
+{
+  if (sBlockCount < sMaxBlocks)
+    sBlocks [sBlockCount++] = {address, bytes};
+  else
+    sUnplaced += 1;
+}
+
+void unplace (uintptr_t const address)
+{
+  for (size_t i = 0; i < sBlockCount; ++i)
+    if (address == sBlocks [i].address)
+    {
+      sBlocks [i] = sBlocks [--sBlockCount];
+      return;
+    }
+  sUnplaced -= 1;
+}
+
+bool before (Block const& a, Block const& b)
+{
+  return a.address < b.address;
+}
+
+void* allocate (size_t const bytes)
+{
+  auto* const block = static_cast<uint8_t*> (std::malloc (sHeaderSize + bytes));
+  if (!block)
+    return nullptr;
+
+  Lock lock;
+  auto* const header = reinterpret_cast<Header*> (block);
+  header->bytes = bytes;
+  header->tag = sTag;
+
+  auto& site = sSites [sTag];
+  site.current += bytes;
+  site.allocations += 1;
+  if (site.current > site.peak)
+    site.peak = site.current;
+  sCurrent += bytes;
+  if (sCurrent > sPeak)
+    sPeak = sCurrent;
+  place (reinterpret_cast<uintptr_t> (block), sHeaderSize + bytes);
+  return block + sHeaderSize;
+}
+
+void release (void* const memory)
+{
+  if (!memory)
+    return;
+
+  auto* const block = static_cast<uint8_t*> (memory) - sHeaderSize;
+  {
+    Lock lock;
+    auto const* const header = reinterpret_cast<Header const*> (block);
+    auto& site = sSites [header->tag];
+    site.current -= header->bytes;
+    site.frees += 1;
+    sCurrent -= header->bytes;
+    unplace (reinterpret_cast<uintptr_t> (block));
+  }
+  std::free (block);
+}
+
+}
+
+Scope::Scope (Tag const tag)
+  : mOuter (sTag)
+{
+  sTag = tag;
+}
+
+Scope::~Scope ()
+{
+  sTag = mOuter;
+}
+
+size_t current ()
+{
+  return sCurrent;
+}
+
+size_t peak ()
+{
+  return sPeak;
+}
+
+uint32_t allocations ()
+{
+  Lock lock;
+  uint32_t count = 0;
+  for (auto const& site : sSites)
+    count += site.allocations;
+  return count;
+}
+
+void print ()
+{
+  uBit.serial.printf ("heap: current %lu peak %lu bytes\r\n",
+                      static_cast<unsigned long> (sCurrent),
+                      static_cast<unsigned long> (sPeak));
+  for (int i = 0; i < TagCount; ++i)
+  {
+    auto const& site = sSites [i];
+    uBit.serial.printf ("  %s: current %lu peak %lu allocations %lu frees %lu\r\n",
+                        sNames [i],
+                        static_cast<unsigned long> (site.current),
+                        static_cast<unsigned long> (site.peak),
+                        static_cast<unsigned long> (site.allocations),
+                        static_cast<unsigned long> (site.frees));
+  }
+
+  // the gaps between the live blocks are free or hold blocks of malloc,
+  // the game is over so the table may be sorted
+  size_t gaps = 0;
+  size_t largest = 0;
+  size_t span = 0;
+  {
+    Lock lock;
+    std::sort (sBlocks, sBlocks + sBlockCount, before);
+    for (size_t i = 1; i < sBlockCount; ++i)
+    {
+      auto const end = sBlocks [i - 1].address + sBlocks [i - 1].bytes;
+      auto const gap = sBlocks [i].address > end ? sBlocks [i].address - end : 0;
+      gaps += gap;
+      largest = std::max (largest, gap);
+    }
+    if (sBlockCount > 0)
+      span = sBlocks [sBlockCount - 1].address + sBlocks [sBlockCount - 1].bytes - sBlocks [0].address;
+  }
+  uBit.serial.printf ("  blocks %lu unplaced %lu span %lu gaps %lu largest gap %lu bytes\r\n",
+                      static_cast<unsigned long> (sBlockCount),
+                      static_cast<unsigned long> (sUnplaced),
+                      static_cast<unsigned long> (span),
+                      static_cast<unsigned long> (gaps),
+                      static_cast<unsigned long> (largest));
+  uBit.serial.printf ("image arena: %u of %u slots, %u bytes\r\n",
+                      static_cast<unsigned> (arena::used ()),
+                      static_cast<unsigned> (arena::SlotCount),
+                      static_cast<unsigned> (arena::usedBytes ()));
+}
+
+}}
+
+// Every new and delete of the game and the DAL goes through the counts
+void* operator new (size_t const bytes)
+{
+  auto* const memory = maze::heap::allocate (bytes);
+  if (!memory)
+    microbit_panic (maze::heap::sPanicOutOfMemory);
+  return memory;
+}
+
+void* operator new[] (size_t const bytes)
+{
+  return operator new (bytes);
+}
+
+void* operator new (size_t const bytes, std::nothrow_t const&) noexcept
+{
+  return maze::heap::allocate (bytes);
+}
+
+void* operator new[] (size_t const bytes, std::nothrow_t const&) noexcept
+{
+  return maze::heap::allocate (bytes);
+}
+
+void operator delete (void* const memory) noexcept
+{
+  maze::heap::release (memory);
+}
+
+void operator delete[] (void* const memory) noexcept
+{
+  maze::heap::release (memory);
+}
+
+void operator delete (void* const memory, std::nothrow_t const&) noexcept
+{
+  maze::heap::release (memory);
+}
+
+void operator delete[] (void* const memory, std::nothrow_t const&) noexcept
+{
+  maze::heap::release (memory);
+}
+
+#if __cpp_sized_deallocation
+void operator delete (void* const memory, size_t) noexcept
+{
+  maze::heap::release (memory);
+}
+
+void operator delete[] (void* const memory, size_t) noexcept
+{
+  maze::heap::release (memory);
+}
+#endif
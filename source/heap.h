@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace maze { namespace heap {
+
+// Sites the game allocates from. All operator new calls are counted,
+// those outside a scope count as other.
+enum Tag {
+  TagOther = 0, TagLevel, TagDistance, TagExplored, TagValidate, TagCount
+};
+
+// Panic code if the heap is exhausted
+int constexpr sPanicOutOfMemory = 72;
+
+// Allocations made while it lives belong to the tag, scopes nest
+class Scope
+{
+public:
+  explicit Scope (Tag tag);
+  ~Scope ();
+
+  Scope (Scope const&) = delete;
+  Scope& operator= (Scope const&) = delete;
+
+private:
+  Tag mOuter;
+};
+
+// Bytes asked for by the live allocations, now and at most so far
+size_t current ();
+size_t peak ();
+
+// operator new calls so far, of all tags
+uint32_t allocations ();
+
+// Dumps the sites, the gaps between the live blocks and the image arena
+// over serial
+void print ();
+
+}}
@@ -0,0 +1,51 @@
+#include "histogram.h"
+
+namespace maze
+{
+
+void Histogram::add (uint32_t const ticks)
+{
+  uint8_t index = 0;
+  for (auto v = ticks >> 1; v > 0 && index < sBuckets - 1; v >>= 1)
+    ++index;
+
+  mBuckets [index] += 1;
+  if (0 == mCount || ticks < mMin)
+    mMin = ticks;
+  if (ticks > mMax)
+    mMax = ticks;
+  mSum += ticks;
+  mCount += 1;
+}
+
+void Histogram::reset ()
+{
+  *this = Histogram ();
+}
+
+uint32_t Histogram::mean () const
+{
+  return mCount ? static_cast<uint32_t> (mSum / mCount) : 0;
+}
+
+uint32_t Histogram::percentile (uint8_t const percent) const
+{
+  if (0 == mCount)
+    return 0;
+
+  // rank of the sample, rounded up
+  auto const rank = (static_cast<uint64_t> (mCount) * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint8_t i = 0; i < sBuckets; ++i)
+  {
+    seen += mBuckets [i];
+    if (seen >= rank && seen > 0)
+    {
+      auto const upper = (2ul << i) - 1;
+      return (upper < mMax) ? upper : mMax;
+    }
+  }
+  return mMax;
+}
+
+}
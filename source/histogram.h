@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace maze
+{
+
+// Fixed memory histogram of durations in ticks of a clock, us on the
+// device and ns on the host, with power of two buckets: bucket 0 holds
+// 0 - 1 ticks, bucket i holds 2^i - 2^(i+1)-1 ticks and the last bucket
+// everything above.
+class Histogram
+{
+public:
+  static uint8_t constexpr sBuckets = 24;
+
+  void add (uint32_t ticks);
+  void reset ();
+
+  uint32_t count () const { return mCount; }
+  uint32_t min () const { return mCount ? mMin : 0; }
+  uint32_t max () const { return mMax; }
+  uint32_t mean () const;
+
+  // Upper bound of the bucket holding the given percentile
+  uint32_t percentile (uint8_t percent) const;
+
+  uint32_t bucket (uint8_t const index) const { return mBuckets [index]; }
+
+private:
+  uint32_t mBuckets [sBuckets] = {};
+  uint32_t mCount = 0;
+  uint32_t mMin = 0;
+  uint32_t mMax = 0;
+  uint64_t mSum = 0;
+};
+
+}
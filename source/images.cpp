@@ -1,4 +1,5 @@
 #include "images.h"
+#include "arena.h"
 
 namespace maze
 {
@@ -130,6 +131,8 @@ static const uint8_t pixel_multiplier[25] = {
   0, 0, 0, 0, 0
 };
 
+static_assert (sizeof (pixel_wave) <= arena::sSlotPixels, "largest icon must fit into an arena slot");
+
 MicroBitImage *image (Image const index)
 {
   static MicroBitImage returnImage;
@@ -137,95 +140,95 @@ MicroBitImage *image (Image const index)
     {
       case ImageSmiley:
         {
-          returnImage = MicroBitImage (5, 5, pixel_smiley);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_smiley);
           break;
         }
       case ImageSadly:
         {
-          returnImage = MicroBitImage (5, 5, pixel_sadly);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_sadly);
           break;
         }
       case ImageHeart:
         {
-          returnImage = MicroBitImage (5, 5, pixel_heart);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_heart);
           break;
         }
       case ImageArrowLeft:
         {
-          returnImage = MicroBitImage (5, 5, pixel_arrow_left);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_arrow_left);
           break;
         }
       case ImageArrowRight:
         {
-          returnImage = MicroBitImage (5, 5, pixel_arrow_right);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_arrow_right);
           break;
         }
       case ImageArrowLeftRight:
         {
-          returnImage = MicroBitImage (5, 5, pixel_arrow_leftright);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_arrow_leftright);
           break;
         }
       case ImageFull:
         {
-          returnImage = MicroBitImage (5, 5, pixel_full);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_full);
           break;
         }
       case ImageDot:
         {
-          returnImage = MicroBitImage (5, 5, pixel_dot);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_dot);
           break;
         }
       case ImageSmallRect:
         {
-          returnImage = MicroBitImage (5, 5, pixel_small);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_small);
           break;
         }
       case ImageLargeRect:
         {
-          returnImage = MicroBitImage (5, 5, pixel_large);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_large);
           break;
         }
       case ImageDoubleRow:
         {
-          returnImage = MicroBitImage (5, 5, pixel_double_row);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_double_row);
           break;
         }
       case ImageTick:
         {
-          returnImage = MicroBitImage (5, 5, pixel_tick);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_tick);
           break;
         }
       case ImageRock:
         {
-          returnImage = MicroBitImage (5, 5, pixel_rock);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_rock);
           break;
         }
       case ImageScissors:
         {
-          returnImage = MicroBitImage (5, 5, pixel_scissors);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_scissors);
           break;
         }
       case ImageWell:
         {
 
-          returnImage = MicroBitImage (5, 5, pixel_well);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_well);
           break;
         }
       case ImageFlash:
         {
-          returnImage = MicroBitImage (5, 5, pixel_flash);
+          returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_flash);
           break;
         }
       case ImageWave:
         {
-          returnImage = MicroBitImage (7, 5, pixel_wave);
+          returnImage = arena::image (arena::SlotIcon, 7, 5, pixel_wave);
           break;
         }
       case ImageMultiplier:
-        returnImage = MicroBitImage (5, 5, pixel_multiplier);
+        returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_multiplier);
       break;
       default:
-        returnImage = MicroBitImage (5, 5, pixel_sadly);
+        returnImage = arena::image (arena::SlotIcon, 5, 5, pixel_sadly);
 
       break;
     }
@@ -0,0 +1,60 @@
+#include "input.h"
+
+namespace maze { namespace input {
+
+void Queue::push (latency::Handler const kind, uint32_t const time)
+{
+  uint8_t const tail = mTail;
+  if (static_cast<uint8_t> (tail - mHead) == sCapacity)
+  {
+    mOverflowTimes [kind] = time;
+    mOverflows [kind] = static_cast<uint8_t> (mOverflows [kind] + 1);
+    return;
+  }
+
+  mKinds [tail & (sCapacity - 1)] = kind;
+  mTimes [tail & (sCapacity - 1)] = time;
+  // published after the slot is written
+  mTail = static_cast<uint8_t> (tail + 1);
+}
+
+bool Queue::pop (Input& input)
+{
+  uint8_t const head = mHead;
+  if (head != mTail)
+  {
+    input.kind = static_cast<latency::Handler> (mKinds [head & (sCapacity - 1)]);
+    input.time = mTimes [head & (sCapacity - 1)];
+    mHead = static_cast<uint8_t> (head + 1);
+    return true;
+  }
+
+  for (uint8_t kind = 0; kind < latency::HandlerCount; ++kind)
+    if (mOverflows [kind] != mOverflowsTaken [kind])
+    {
+      mOverflowsTaken [kind] += 1;
+      input.kind = static_cast<latency::Handler> (kind);
+      input.time = mOverflowTimes [kind];
+      return true;
+    }
+  return false;
+}
+
+bool Queue::empty () const
+{
+  if (mHead != mTail)
+    return false;
+  for (uint8_t kind = 0; kind < latency::HandlerCount; ++kind)
+    if (mOverflows [kind] != mOverflowsTaken [kind])
+      return false;
+  return true;
+}
+
+void Queue::clear ()
+{
+  mHead = mTail;
+  for (uint8_t kind = 0; kind < latency::HandlerCount; ++kind)
+    mOverflowsTaken [kind] = mOverflows [kind];
+}
+
+}}
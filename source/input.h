@@ -0,0 +1,48 @@
+#pragma once
+
+#include "latency.h"
+
+#include <cstdint>
+
+namespace maze { namespace input {
+
+uint8_t constexpr sCapacity = 32;
+
+struct Input {
+  latency::Handler kind = latency::Left;
+  // low 32 bits of the event time in us
+  uint32_t time = 0;
+};
+
+// Inputs from the event handlers, which may run in an interrupt, to the
+// game fiber. Lock free for one producer and one consumer: each side only
+// writes its own index. Inputs that do not fit are counted per kind and
+// handed out after the ring, so none is lost, only their order.
+class Queue
+{
+public:
+  // producer side
+  void push (latency::Handler kind, uint32_t time);
+
+  // consumer side, false if there is no input
+  bool pop (Input& input);
+  bool empty () const;
+  // drops all queued inputs
+  void clear ();
+
+private:
+  // The capacity must be a power of two.
+  // Head and tail only grow and wrap, their difference is the fill level.
+  uint8_t volatile mKinds [sCapacity];
+  uint32_t volatile mTimes [sCapacity];
+  uint8_t volatile mHead = 0;
+  uint8_t volatile mTail = 0;
+
+  // written by the producer only
+  uint8_t volatile mOverflows [latency::HandlerCount] = {};
+  uint32_t volatile mOverflowTimes [latency::HandlerCount] = {};
+  // written by the consumer only
+  uint8_t mOverflowsTaken [latency::HandlerCount] = {};
+};
+
+}}
@@ -0,0 +1,79 @@
+#include "latency.h"
+
+#include <MicroBit.h>
+
+extern MicroBit uBit;
+
+namespace maze { namespace latency {
+
+namespace
+{
+
+Stats sStats [HandlerCount];
+
+char const* const sNames [HandlerCount] = {
+  "left", "right", "forward", "map"
+};
+
+uint32_t since (uint64_t const time)
+{
+  return static_cast<uint32_t> (system_timer_current_time_us () - time);
+}
+
+void print (char const* stage, Histogram const& histogram)
+{
+  uBit.serial.printf ("  %s us: n %lu min %lu mean %lu p50 %lu p99 %lu max %lu\r\n",
+                      stage,
+                      static_cast<unsigned long> (histogram.count ()),
+                      static_cast<unsigned long> (histogram.min ()),
+                      static_cast<unsigned long> (histogram.mean ()),
+                      static_cast<unsigned long> (histogram.percentile (50)),
+                      static_cast<unsigned long> (histogram.percentile (99)),
+                      static_cast<unsigned long> (histogram.max ()));
+}
+
+}
+
+void received (Handler const handler)
+{
+  sStats [handler].received += 1;
+}
+
+void logic (Handler const handler, uint64_t const eventTime)
+{
+  sStats [handler].handled += 1;
+  sStats [handler].logic.add (since (eventTime));
+}
+
+void output (Handler const handler, uint64_t const eventTime)
+{
+  sStats [handler].output.add (since (eventTime));
+}
+
+Stats const& stats (Handler const handler)
+{
+  return sStats [handler];
+}
+
+char const* name (Handler const handler)
+{
+  return sNames [handler];
+}
+
+void print ()
+{
+  for (int i = 0; i < HandlerCount; ++i)
+  {
+    auto const& stats = sStats [i];
+    auto const dropped = (stats.received > stats.handled) ? stats.received - stats.handled : 0;
+    uBit.serial.printf ("%s: received %lu handled %lu dropped %lu\r\n",
+                        sNames [i],
+                        static_cast<unsigned long> (stats.received),
+                        static_cast<unsigned long> (stats.handled),
+                        static_cast<unsigned long> (dropped));
+    print ("logic", stats.logic);
+    print ("output", stats.output);
+  }
+}
+
+}}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "histogram.h"
+
+#include <cstdint>
+
+namespace maze { namespace latency {
+
+enum Handler {
+  Left = 0, Right, Forward, ToggleMap, HandlerCount
+};
+
+// An input event was raised, whether its handler runs or not
+void received (Handler handler);
+
+// Measures one handled event from the time it was raised:
+// until the game logic is updated and until its output is done,
+// which is after display and sound. Inputs applied together share
+// one output.
+void logic (Handler handler, uint64_t eventTime);
+void output (Handler handler, uint64_t eventTime);
+
+// Events of one handler and their times in us
+struct Stats {
+  uint32_t received = 0;
+  uint32_t handled = 0;
+  Histogram logic;
+  Histogram output;
+};
+
+Stats const& stats (Handler handler);
+char const* name (Handler handler);
+
+// Dumps the histograms and dropped events over serial
+void print ();
+
+}}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "bitmaze.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+// Level defined at compile time, placed in flash:
+// tiles as in the level definitions, row y, column x, the start with its
+// direction and the goal. The checks and the layer bits below are
+// evaluated by the compiler, an invalid level does not build.
+template <int32_t Width, int32_t Height>
+struct Level {
+  static_assert (Width > 2 && Height > 2, "a level needs a border around its floor");
+
+  uint8_t tiles [Height][Width];
+  int32_t sx;
+  int32_t sy;
+  uint8_t sd;
+  int32_t ex;
+  int32_t ey;
+
+  static constexpr int32_t width () { return Width; }
+  static constexpr int32_t height () { return Height; }
+  // 32 bit words per layer row, as in BitMaze
+  static constexpr int32_t stride () { return (Width + 31) / 32; }
+  static constexpr int32_t words () { return LayerCount * Height * stride (); }
+
+  constexpr uint8_t tile (int32_t const x, int32_t const y) const { return tiles [y][x]; }
+};
+
+// The recursions run along a row or a column, so their depth stays below
+// the compiler limits for any level that fits on the device
+
+constexpr bool isTile (uint8_t const tile)
+{
+  return tile <= 3 || 8 == tile || 9 == tile;
+}
+
+template <int32_t W, int32_t H>
+constexpr bool validRow (Level<W, H> const& level, int32_t const y, int32_t const x = 0)
+{
+  return W == x || (isTile (level.tile (x, y)) && validRow (level, y, x + 1));
+}
+
+template <int32_t W, int32_t H>
+constexpr bool validTiles (Level<W, H> const& level, int32_t const y = 0)
+{
+  return H == y || (validRow (level, y) && validTiles (level, y + 1));
+}
+
+template <int32_t W, int32_t H>
+constexpr bool blockingRow (Level<W, H> const& level, int32_t const y, int32_t const x = 0)
+{
+  return W == x || (tileInLayer (LayerBlocking, level.tile (x, y)) && blockingRow (level, y, x + 1));
+}
+
+template <int32_t W, int32_t H>
+constexpr bool blockingColumn (Level<W, H> const& level, int32_t const x, int32_t const y = 0)
+{
+  return H == y || (tileInLayer (LayerBlocking, level.tile (x, y)) && blockingColumn (level, x, y + 1));
+}
+
+// Blocking walls all around, nobody walks off the level
+template <int32_t W, int32_t H>
+constexpr bool closedBorder (Level<W, H> const& level)
+{
+  return blockingRow (level, 0) && blockingRow (level, H - 1) &&
+         blockingColumn (level, 0) && blockingColumn (level, W - 1);
+}
+
+// Inside the border, the cells around are in the level
+template <int32_t W, int32_t H>
+constexpr bool isInterior (Level<W, H> const&, int32_t const x, int32_t const y)
+{
+  return x > 0 && y > 0 && x < W - 1 && y < H - 1;
+}
+
+// The start is no wall, no trap and looks into a known direction
+template <int32_t W, int32_t H>
+constexpr bool validStart (Level<W, H> const& level)
+{
+  return isInterior (level, level.sx, level.sy) && level.sd < 4 &&
+         !tileInLayer (LayerBlocking, level.tile (level.sx, level.sy)) &&
+         !tileInLayer (LayerTrap, level.tile (level.sx, level.sy));
+}
+
+template <int32_t W, int32_t H>
+constexpr bool validGoal (Level<W, H> const& level)
+{
+  return isInterior (level, level.ex, level.ey) &&
+         !tileInLayer (LayerBlocking, level.tile (level.ex, level.ey)) &&
+         !tileInLayer (LayerTrap, level.tile (level.ex, level.ey));
+}
+
+template <int32_t W, int32_t H>
+constexpr int32_t countRow (Level<W, H> const& level, uint8_t const tile, int32_t const y, int32_t const x = 0)
+{
+  return W == x ? 0 : (tile == level.tile (x, y) ? 1 : 0) + countRow (level, tile, y, x + 1);
+}
+
+// Number of cells of a tile value
+template <int32_t W, int32_t H>
+constexpr int32_t count (Level<W, H> const& level, uint8_t const tile, int32_t const y = 0)
+{
+  return H == y ? 0 : countRow (level, tile, y) + count (level, tile, y + 1);
+}
+
+// Bits x to x + 31 of a layer row
+template <int32_t W, int32_t H>
+constexpr uint32_t layerWord (Level<W, H> const& level, Layer const layer, int32_t const y, int32_t const x, int32_t const bit = 0)
+{
+  return (32 == bit || W <= x + bit) ? 0u
+       : (tileInLayer (layer, level.tile (x + bit, y)) ? 1u << bit : 0u) | layerWord (level, layer, y, x, bit + 1);
+}
+
+// Word i of the layer bits, laid out like the BitMaze buffer
+template <int32_t W, int32_t H>
+constexpr uint32_t layerWord (Level<W, H> const& level, int32_t const i)
+{
+  return layerWord (level, static_cast<Layer> (i / (H * Level<W, H>::stride ())),
+                    i / Level<W, H>::stride () % H, i % Level<W, H>::stride () * 32);
+}
+
+// All layers of a level, ready to be copied into a BitMaze,
+// including the visible layer the map is drawn from
+template <int32_t W, int32_t H>
+struct LevelBits {
+  uint32_t words [Level<W, H>::words ()];
+};
+
+template <int32_t... I>
+struct Indices {};
+
+template <int32_t N, int32_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+
+template <int32_t... I>
+struct MakeIndices<0, I...> {
+  using Type = Indices<I...>;
+};
+
+template <int32_t W, int32_t H, int32_t... I>
+constexpr LevelBits<W, H> layerBits (Level<W, H> const& level, Indices<I...>)
+{
+  return {{ layerWord (level, I)... }};
+}
+
+template <int32_t W, int32_t H>
+constexpr LevelBits<W, H> layerBits (Level<W, H> const& level)
+{
+  return layerBits (level, typename MakeIndices<Level<W, H>::words ()>::Type ());
+}
+
+}
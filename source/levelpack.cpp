@@ -0,0 +1,129 @@
+#include "levelpack.h"
+
+namespace maze
+{
+
+namespace
+{
+
+uint16_t read16 (uint8_t const* p)
+{
+  return p [0] | (p [1] << 8);
+}
+
+uint32_t read32 (uint8_t const* p)
+{
+  return p [0] | (p [1] << 8) | (p [2] << 16) | (static_cast<uint32_t> (p [3]) << 24);
+}
+
+class BitReader
+{
+public:
+  explicit BitReader (uint8_t const* data) : mData (data) {}
+
+  uint8_t read (uint8_t const bits)
+  {
+    uint8_t value = 0;
+    for (uint8_t i = 0; i < bits; ++i, ++mBit)
+      if (mData [mBit >> 3] & (1 << (mBit & 7)))
+        value |= 1 << i;
+    return value;
+  }
+
+private:
+  uint8_t const* mData;
+  uint32_t mBit = 0;
+};
+
+// Calls emit (x, tile) for each tile of the row until width
+template <typename Emit>
+void decodeRow (uint8_t const* row, int32_t const width, Emit const& emit)
+{
+  BitReader reader (row);
+  for (int32_t x = 0; x < width;)
+  {
+    auto const code = reader.read (sPackCodeBits);
+    if (sPackCodeRun == code)
+    {
+      auto const length = reader.read (sPackRunBits) + sPackRunMin;
+      for (int i = 0; i < length && x < width; ++i)
+        emit (x++, 9);
+    }
+    else if (sPackCodeEscape == code)
+      emit (x++, reader.read (sPackEscapeBits));
+    else
+      emit (x++, sPackTiles [code]);
+  }
+}
+
+}
+
+bool LevelPack::valid () const
+{
+  return 'M' == mData [0] && 'Z' == mData [1] && sPackVersion == mData [2];
+}
+
+uint8_t LevelPack::count () const
+{
+  return mData [3];
+}
+
+uint8_t const* LevelPack::level (uint8_t const level) const
+{
+  return mData + read32 (mData + sPackHeaderSize + 4 * level);
+}
+
+LevelInfo LevelPack::info (uint8_t const index) const
+{
+  auto const* p = level (index);
+  LevelInfo info;
+  info.width = read16 (p + 0);
+  info.height = read16 (p + 2);
+  info.sx = read16 (p + 4);
+  info.sy = read16 (p + 6);
+  info.ex = read16 (p + 8);
+  info.ey = read16 (p + 10);
+  info.sd = p [12];
+  return info;
+}
+
+void LevelPack::row (uint8_t const index, int32_t const y, uint8_t* tiles) const
+{
+  auto const* p = level (index);
+  auto const width = read16 (p);
+  auto const* row = p + read32 (p + sPackLevelHeaderSize + 4 * y);
+  decodeRow (row, width, [tiles] (int32_t const x, uint8_t const tile) { tiles [x] = tile; });
+}
+
+void LevelPack::span (uint8_t const index, int32_t const y, int32_t const x, int32_t const count, uint8_t* tiles) const
+{
+  auto const* p = level (index);
+  int32_t const width = read16 (p);
+  for (int32_t i = 0; i < count; ++i)
+    tiles [i] = 9;
+  if (x >= width)
+    return;
+
+  auto const* row = p + read32 (p + sPackLevelHeaderSize + 4 * y);
+  auto const end = (x + count < width) ? x + count : width;
+  decodeRow (row, end, [tiles, x] (int32_t const column, uint8_t const tile) {
+    if (column >= x)
+      tiles [column - x] = tile;
+  });
+}
+
+void LevelPack::load (uint8_t const index, BitMaze& maze) const
+{
+  auto const* p = level (index);
+  auto const width = read16 (p);
+  auto const height = read16 (p + 2);
+
+  maze.resize (width, height);
+  for (int32_t y = 0; y < height; ++y)
+  {
+    auto const* row = p + read32 (p + sPackLevelHeaderSize + 4 * y);
+    decodeRow (row, width, [&maze, y] (int32_t const x, uint8_t const tile) { maze.setTile (x, y, tile); });
+  }
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "bitmaze.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+// Level pack layout, all numbers little endian:
+//
+// pack:  'M' 'Z' version count, u32 offset of each level from the pack start
+// level: u16 width, height, sx, sy, ex, ey, u8 sd, u8 reserved,
+//        u32 offset of each row from the level start, row data
+// row:   byte aligned bit stream, lowest bit first, of 3 bit codes:
+//        0 - 5: one tile of sPackTiles
+//        6:     run of blocking walls, 5 bit length - 2 follows
+//        7:     escape for any other tile, 4 bit tile value follows
+//
+uint8_t constexpr sPackVersion = 1;
+uint8_t constexpr sPackCodeBits = 3;
+uint8_t constexpr sPackCodeRun = 6;
+uint8_t constexpr sPackCodeEscape = 7;
+uint8_t constexpr sPackRunBits = 5;
+uint8_t constexpr sPackRunMin = 2;
+uint8_t constexpr sPackRunMax = sPackRunMin + (1 << sPackRunBits) - 1;
+uint8_t constexpr sPackEscapeBits = 4;
+uint8_t constexpr sPackTiles [6] = {0, 1, 2, 3, 8, 9};
+
+uint32_t constexpr sPackHeaderSize = 4;
+uint32_t constexpr sPackLevelHeaderSize = 14;
+
+// Levels shipped with the game, generated by tools/levelpack.cpp
+extern uint8_t const sLevelPack [];
+
+struct LevelInfo {
+  int32_t width = 0;
+  int32_t height = 0;
+  int32_t sx = 0;
+  int32_t sy = 0;
+  int32_t ex = 0;
+  int32_t ey = 0;
+  uint8_t sd = 0;
+};
+
+// Reads levels straight from a pack in flash, row by row
+class LevelPack
+{
+public:
+  explicit LevelPack (uint8_t const* data) : mData (data) {}
+
+  bool valid () const;
+  uint8_t count () const;
+  LevelInfo info (uint8_t level) const;
+
+  // Decodes row y of the level, tiles must hold width values
+  void row (uint8_t level, int32_t y, uint8_t* tiles) const;
+
+  // Decodes count tiles of row y starting at column x, stops decoding
+  // after them. Tiles right of the level are blocking walls.
+  void span (uint8_t level, int32_t y, int32_t x, int32_t count, uint8_t* tiles) const;
+
+  // Decodes the whole level into the maze without a row buffer
+  void load (uint8_t level, BitMaze& maze) const;
+
+private:
+  uint8_t const* level (uint8_t level) const;
+
+  uint8_t const* mData;
+};
+
+}
@@ -0,0 +1,54 @@
+// Generated by tools/levelpack.cpp, do not edit.
+
+#include "levelpack.h"
+
+namespace maze
+{
+
+uint8_t const sLevelPack [] = {
+  0x4d, 0x5a, 0x01, 0x03, 0x10, 0x00, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x00, 
+  0x11, 0x01, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x05, 0x00, 0x09, 0x00, 
+  0x05, 0x00, 0x01, 0x00, 0x03, 0x00, 0x3e, 0x00, 0x00, 0x00, 0x3f, 0x00, 
+  0x00, 0x00, 0x43, 0x00, 0x00, 0x00, 0x47, 0x00, 0x00, 0x00, 0x4b, 0x00, 
+  0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x55, 0x00, 0x00, 0x00, 0x5a, 0x00, 
+  0x00, 0x00, 0x5f, 0x00, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00, 0x69, 0x00, 
+  0x00, 0x00, 0x6e, 0x00, 0x00, 0x00, 0x56, 0x05, 0x14, 0x70, 0x16, 0x85, 
+  0x43, 0x0a, 0x0b, 0x45, 0x51, 0x75, 0x16, 0x45, 0x01, 0x14, 0x84, 0x01, 
+  0x45, 0x01, 0x03, 0x16, 0x06, 0x05, 0x00, 0x03, 0x14, 0x06, 0x06, 0x40, 
+  0x09, 0x81, 0x06, 0x06, 0x40, 0x59, 0x14, 0x28, 0x06, 0xeb, 0xe0, 0x00, 
+  0x14, 0x05, 0x00, 0x80, 0x00, 0x0a, 0x56, 0x0f, 0x00, 0x0f, 0x00, 0x0b, 
+  0x00, 0x0b, 0x00, 0x07, 0x00, 0x01, 0x00, 0x01, 0x00, 0x4a, 0x00, 0x00, 
+  0x00, 0x4b, 0x00, 0x00, 0x00, 0x51, 0x00, 0x00, 0x00, 0x55, 0x00, 0x00, 
+  0x00, 0x5b, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00, 0x00, 0x66, 0x00, 0x00, 
+  0x00, 0x6a, 0x00, 0x00, 0x00, 0x70, 0x00, 0x00, 0x00, 0x76, 0x00, 0x00, 
+  0x00, 0x7c, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x86, 0x00, 0x00, 
+  0x00, 0x8b, 0x00, 0x00, 0x00, 0x91, 0x00, 0x00, 0x00, 0x6e, 0x05, 0x00, 
+  0x00, 0x05, 0x00, 0x14, 0x85, 0x0b, 0x8a, 0xa2, 0x05, 0x00, 0x00, 0x45, 
+  0x51, 0x14, 0x85, 0x07, 0x8a, 0xc2, 0x01, 0x05, 0x80, 0x14, 0x40, 0x01, 
+  0x14, 0x85, 0x0b, 0x1d, 0x50, 0x4d, 0x01, 0x61, 0x15, 0x00, 0x14, 0x0e, 
+  0x70, 0x40, 0xe1, 0x80, 0x02, 0x05, 0x50, 0x00, 0x40, 0x01, 0x14, 0x85, 
+  0x0b, 0x3c, 0x00, 0x05, 0x01, 0x40, 0x45, 0x01, 0x14, 0x45, 0xe1, 0x00, 
+  0x0f, 0x14, 0x05, 0x00, 0x14, 0x00, 0x00, 0x14, 0x6e, 0x15, 0x00, 0x15, 
+  0x00, 0x07, 0x00, 0x0b, 0x00, 0x13, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x62, 
+  0x00, 0x00, 0x00, 0x63, 0x00, 0x00, 0x00, 0x6b, 0x00, 0x00, 0x00, 0x71, 
+  0x00, 0x00, 0x00, 0x79, 0x00, 0x00, 0x00, 0x81, 0x00, 0x00, 0x00, 0x89, 
+  0x00, 0x00, 0x00, 0x91, 0x00, 0x00, 0x00, 0x99, 0x00, 0x00, 0x00, 0x9e, 
+  0x00, 0x00, 0x00, 0xa6, 0x00, 0x00, 0x00, 0xad, 0x00, 0x00, 0x00, 0xb5, 
+  0x00, 0x00, 0x00, 0xbc, 0x00, 0x00, 0x00, 0xc4, 0x00, 0x00, 0x00, 0xca, 
+  0x00, 0x00, 0x00, 0xd2, 0x00, 0x00, 0x00, 0xd8, 0x00, 0x00, 0x00, 0xe0, 
+  0x00, 0x00, 0x00, 0xe8, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x9e, 
+  0x05, 0x00, 0x00, 0x0d, 0x00, 0x34, 0x0d, 0x50, 0x85, 0x0f, 0x1c, 0xe0, 
+  0x80, 0x02, 0x45, 0x01, 0x00, 0x00, 0x00, 0x00, 0x45, 0x51, 0x45, 0xe1, 
+  0x80, 0xa2, 0x70, 0x40, 0x51, 0x14, 0x05, 0x80, 0x14, 0x45, 0x01, 0x14, 
+  0x40, 0x51, 0x45, 0xe1, 0x80, 0xc2, 0x01, 0x0e, 0x28, 0x0a, 0x4d, 0x01, 
+  0x14, 0x05, 0x50, 0x34, 0x00, 0x50, 0x2e, 0x28, 0x5c, 0xe0, 0x00, 0x45, 
+  0x53, 0x14, 0x05, 0x50, 0x14, 0x00, 0x52, 0x45, 0x51, 0x14, 0x0e, 0x28, 
+  0x0a, 0x0f, 0x05, 0x00, 0x00, 0x05, 0xd0, 0x01, 0x40, 0x53, 0x65, 0x51, 
+  0x14, 0x85, 0x0b, 0x8a, 0x02, 0x05, 0x50, 0x14, 0x05, 0x50, 0x10, 0x05, 
+  0x50, 0x85, 0x03, 0x5c, 0x50, 0x38, 0xa0, 0x05, 0x50, 0x00, 0x00, 0x50, 
+  0x00, 0x40, 0x51, 0x0e, 0x70, 0x40, 0xe1, 0x02, 0x07, 0x05, 0xd0, 0x14, 
+  0x45, 0x01, 0x00, 0x50, 0x51, 0x85, 0x03, 0x1c, 0x50, 0x14, 0x45, 0x51, 
+  0x14, 0x05, 0x00, 0x20, 0x05, 0x50, 0x14, 0x05, 0x50, 0x9e
+};
+
+}
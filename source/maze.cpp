@@ -2,25 +2,80 @@
 #include <vector>
 #include <tuple>
 #include <string>
+#include <cstring>
 
 #include "maze.h"
 #include "melody.h"
+#include "sound.h"
+#include "latency.h"
+#include "profile.h"
+#include "pulse.h"
+#include "arena.h"
+#include "heap.h"
+#include "input.h"
 #include "images.h"
+#include "bitmaze.h"
+#include "distance.h"
+#include "explored.h"
+#include "generator.h"
+#include "ghost.h"
+#include "level.h"
+#include "levelpack.h"
+#include "radio.h"
+#include "tiles.h"
+#include "savegame.h"
+#include "validate.h"
+#include "view.h"
 
 #include <MicroBit.h>
 
 extern MicroBit uBit;
 
+// 1: page the level in tiles through a small cache instead of keeping it
+// in RAM, for worlds larger than the RAM
+#ifndef MAZE_TILED_WORLD
+#define MAZE_TILED_WORLD 0
+#endif
+
+// 1: race other players of the same level over the radio, they show up as
+// ghosts. The radio needs bluetooth disabled in config.json.
+#ifndef MAZE_GHOST_RACE
+#define MAZE_GHOST_RACE 0
+#endif
+
+// 1: doors of the hand made level open when the player reaches their
+// lever and some of its walls come and go on a timer. The distance field
+// is repaired around every change instead of computed again.
+#ifndef MAZE_DYNAMIC_WALLS
+#define MAZE_DYNAMIC_WALLS 0
+#endif
+
+static_assert (!(MAZE_DYNAMIC_WALLS && MAZE_TILED_WORLD), "the tiled world can not change its walls");
+
 // TODO:
 // - play victory melody
 // - show floor and ceiling hole for up down
 
 namespace
 {
-uint8_t constexpr sDI = 255;
 uint8_t constexpr sRGB = 25;
-float constexpr sSlowestPulse = 1200.f /*ms*/;
-float constexpr sMinPulseResolution = 50.f /*ms*/;
+// Upper bound for the pulse fiber sleep while the led pulses, a move
+// shows up after this at the latest
+unsigned long constexpr sMaxPulseSleep = 200ul /*ms*/;
+
+// Own event source for game state changes
+uint16_t constexpr sMazeEventId = 9500;
+uint16_t constexpr sMazeEvtEnd = 1;
+uint16_t constexpr sMazeEvtInput = 2;
+// the floor under the player changed or the game ended
+uint16_t constexpr sMazeEvtFloor = 3;
+// a fiber of the game is through
+uint16_t constexpr sMazeEvtDone = 4;
+
+// North means looking to row zero
+enum Direction {
+  North = 0, East, South, West
+};
 
 // Array row, column (y, x)
 // 9: blocking wall
@@ -34,51 +89,161 @@ float constexpr sMinPulseResolution = 50.f /*ms*/;
 // 0 - 4: no wall visible
 // 5 - 9: wall visible
 //
-using Row = std::vector<uint8_t>;
-using Maze = std::vector<Row>;
-Maze const sMaze = {
-// 0  1  2  3  4  5  6  7  8  9  A  B
-  {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}, // 0
-  {9, 0, 0, 2, 1, 0, 8, 3, 9, 9, 9, 9}, // 1
-  {9, 0, 9, 9, 9, 1, 9, 0, 9, 9, 9, 9}, // 2
-  {9, 0, 9, 0, 9, 2, 9, 3, 9, 9, 9, 9}, // 3
-  {9, 0, 9, 0, 0, 0, 9, 0, 8, 0, 9, 9}, // 4
-  {9, 0, 9, 0, 0, 9, 9, 8, 9, 0, 9, 9}, // 5
-  {9, 0, 0, 0, 0, 9, 9, 0, 9, 0, 9, 9}, // 6
-  {9, 9, 0, 0, 9, 8, 0, 2, 0, 8, 9, 9}, // 7
-  {9, 9, 0, 0, 9, 8, 9, 0, 9, 0, 0, 9}, // 8
-  {9, 9, 3, 9, 3, 0, 9, 9, 9, 0, 0, 9}, // 9
-  {9, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 9}, // A
-  {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}  // B
+// The level and its layer bits live in flash, the bits are copied into
+// sMaze on start.
+constexpr maze::Level<12, 12> sLevel = {
+  {
+  // 0  1  2  3  4  5  6  7  8  9  A  B
+    {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}, // 0
+    {9, 0, 0, 2, 1, 0, 8, 3, 9, 9, 9, 9}, // 1
+    {9, 0, 9, 9, 9, 1, 9, 0, 9, 9, 9, 9}, // 2
+    {9, 0, 9, 0, 9, 2, 9, 3, 9, 9, 9, 9}, // 3
+    {9, 0, 9, 0, 0, 0, 9, 0, 8, 0, 9, 9}, // 4
+    {9, 0, 9, 0, 0, 9, 9, 8, 9, 0, 9, 9}, // 5
+    {9, 0, 0, 0, 0, 9, 9, 0, 9, 0, 9, 9}, // 6
+    {9, 9, 0, 0, 9, 8, 0, 2, 0, 8, 9, 9}, // 7
+    {9, 9, 0, 0, 9, 8, 9, 0, 9, 0, 0, 9}, // 8
+    {9, 9, 3, 9, 3, 0, 9, 9, 9, 0, 0, 9}, // 9
+    {9, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 9}, // A
+    {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}  // B
+  },
+  5, 9, West, // start
+  5, 1        // goal
 };
 
-// North means looking to row zero
-enum Direction {
-  North = 0, East, South, West
+static_assert (maze::validTiles (sLevel), "hand made level: unknown tile");
+// the view and the moves read the cells around the player without bounds checks
+static_assert (maze::closedBorder (sLevel), "hand made level: open border");
+static_assert (maze::validStart (sLevel), "hand made level: start not on the floor inside the border");
+static_assert (maze::validGoal (sLevel), "hand made level: goal not on the floor inside the border");
+
+constexpr auto sLevelBits = maze::layerBits (sLevel);
+int32_t constexpr sLevelWalls = maze::count (sLevel, 9);
+int32_t constexpr sLevelSecrets = maze::count (sLevel, 8);
+
+// Blocking walls of the hand made level that open for good once the
+// player reaches their lever
+struct Door {
+  int32_t leverX;
+  int32_t leverY;
+  int32_t x;
+  int32_t y;
+};
+Door constexpr sDoors [] = {
+  {1, 10, 6, 4} // the dead end bottom left opens the middle room to the goal
+};
+size_t constexpr sDoorCount = sizeof (sDoors) / sizeof (sDoors [0]);
+
+// Floor cells of the hand made level that turn into a blocking wall and
+// back every period, not while the player stands on them
+struct TimedWall {
+  int32_t x;
+  int32_t y;
+  uint32_t period;
+};
+TimedWall constexpr sTimedWalls [] = {
+  {6, 7, 4000ul /*ms*/} // the short way to the goal from the start
 };
+size_t constexpr sTimedWallCount = sizeof (sTimedWalls) / sizeof (sTimedWalls [0]);
+
+constexpr bool isFloor (int32_t const x, int32_t const y)
+{
+  return maze::isInterior (sLevel, x, y) && 0 == sLevel.tile (x, y);
+}
+
+constexpr bool validDoors (size_t const i = 0)
+{
+  return sDoorCount == i ||
+         (maze::isInterior (sLevel, sDoors [i].x, sDoors [i].y) && 9 == sLevel.tile (sDoors [i].x, sDoors [i].y) &&
+          isFloor (sDoors [i].leverX, sDoors [i].leverY) && validDoors (i + 1));
+}
+
+constexpr bool validTimedWalls (size_t const i = 0)
+{
+  return sTimedWallCount == i ||
+         (isFloor (sTimedWalls [i].x, sTimedWalls [i].y) && sTimedWalls [i].period > 0 &&
+          !(sTimedWalls [i].x == sLevel.sx && sTimedWalls [i].y == sLevel.sy) &&
+          !(sTimedWalls [i].x == sLevel.ex && sTimedWalls [i].y == sLevel.ey) && validTimedWalls (i + 1));
+}
+
+static_assert (validDoors (), "hand made level: a door not on a wall or its lever not on the floor");
+static_assert (validTimedWalls (), "hand made level: a timed wall not on the floor, on the start or on the goal");
+static_assert (sDoorCount <= maze::save::sMaxDoors && sTimedWallCount <= maze::save::sMaxTimedWalls,
+  "hand made level: more changing walls than a save keeps");
+
+using maze::BitMaze;
+using maze::LayerBlocking;
+using maze::LayerVisible;
+using maze::LayerTrap;
+using maze::LayerDark;
+using maze::LayerTwister;
+#if MAZE_TILED_WORLD
+using Maze = maze::TileCache;
+#else
+using Maze = BitMaze;
+#endif
+Maze sMaze;
+
+// Walking distance of each cell to the goal, computed on start
+using maze::DistanceField;
+DistanceField sDistance;
+
+// Cells the player has seen, the map only shows their walls. Worlds
+// larger than this have no fog, their whole map is open. The bits of the
+// largest fit into a save snapshot.
+int32_t constexpr sMaxExplored = 64;
+static_assert ((sMaxExplored + 31) / 32 * sMaxExplored <= maze::save::sMaxExploredWords,
+  "explored cells do not fit into a save snapshot");
+maze::Explored sExplored;
+bool sFog = false;
 
 enum Mode {
   Floor = 0, Map
 };
 
 struct Game {
-  int32_t sx = 5;
-  int32_t sy = 9;
-  Direction sd = West;
-  int32_t ex = 5;
-  int32_t ey = 1;
-} const sGame;
-
-using Colorf = std::tuple<float, float, float>;
+  int32_t sx = sLevel.sx;
+  int32_t sy = sLevel.sy;
+  Direction sd = static_cast<Direction> (sLevel.sd);
+  int32_t ex = sLevel.ex;
+  int32_t ey = sLevel.ey;
+} sGame;
+
+// Level to play: the hand made one, one of the level pack or a generated one
+enum LevelSource {
+  HandMade = 0, Packed, Generated
+};
+LevelSource constexpr sLevelSource = HandMade;
+// Level of the level pack
+uint8_t constexpr sPackedLevel = 0;
+// Seed of the generated level
+uint32_t constexpr sLevelSeed = 1;
+// Generated levels stay small on the device to keep the boot time short
+int32_t constexpr sGeneratedSize = 15;
+// Invalid generated levels are replaced by the one of the next seed
+uint32_t constexpr sGenerateAttempts = 8;
+// Tiles per side of the generated tiled world
+int32_t constexpr sWorldTiles = 4096;
+// Tiled worlds have no distance field, the pulse uses the manhattan distance up to this
+uint32_t constexpr sTiledPulseRange = 64;
+
+using Color = std::tuple<uint8_t, uint8_t, uint8_t>;
 struct Floor {
   uint8_t brightness = 15;
   
   // distance pulse rgb handling - defaults to largest distance
-  Colorf rgb = std::make_tuple (0.f, 0.f, 0.f);
-  float pulse = 1.f;
+  Color rgb = std::make_tuple (0, 0, 0);
+  // Q16
+  uint32_t pulse = maze::pulse::sQ16One;
   unsigned long lastPulseStart = 0ul;
+  // colour currently shown by the rgb led
+  Color shown = std::make_tuple (0, 0, 0);
 } sFloor;
 
+// Cost of the rgb led pulse, dumped over serial at the end of a game
+using maze::PulseStats;
+PulseStats sPulseStats;
+
 struct Player {
   int32_t px = 1;
   int32_t py = 1;
@@ -89,76 +254,163 @@ struct Player {
 } sPlayer;
 
 struct MazePart {
-  // visibility
-  bool front = false;
-  bool left = false;
-  bool right = false;
   // mobility
   bool blocked = false;
 };
 
+// Other players of the same level
+maze::ghost::Race sRace;
+maze::radio::Transport sRadio;
+uint8_t constexpr sGhostGroup = 42;
+
 MicroBitImage sScreen;
-MicroBitImage sMap;
+MicroBitImage sMapView;
 bool sAnimationActive = false;
 
 MazePart
 getMazePart (Maze const &maze, Player const &player)
 {
   MazePart part;
-  switch (player.di)
+  part.blocked = maze::isBlocked (maze, player.px, player.py, player.di);
+  return part;
+}
+
+// first direction without a blocking wall in front
+Direction getOpenDirection (Maze const& maze, int32_t const x, int32_t const y)
+{
+  for (int di = 0; di < 4; ++di)
+    if (!maze::isBlocked (maze, x, y, di))
+      return static_cast<Direction> (di);
+  return North;
+}
+
+#if MAZE_TILED_WORLD
+
+maze::LevelPack const sPack (maze::sLevelPack);
+maze::PackTiles const sPackTiles (sPack, sPackedLevel);
+maze::GeneratedTiles const sGeneratedTiles (sLevelSeed, sWorldTiles, sWorldTiles);
+
+void loadLevel (Maze& maze, DistanceField&, Game& game)
+{
+  if (Packed == sLevelSource && sPack.valid () && sPackedLevel < sPack.count ())
   {
-  case North:
-    part.blocked = 8 < maze[player.py - 1][player.px + 0];
-    part.front = 4 < maze[player.py - 1][player.px + 0];
-    part.left = 4 < maze[player.py + 0][player.px - 1];
-    part.right = 4 < maze[player.py + 0][player.px + 1];
-    break;
-  case South:
-    part.blocked = 8 < maze[player.py + 1][player.px + 0];
-    part.front = 4 < maze[player.py + 1][player.px + 0];
-    part.left = 4 < maze[player.py + 0][player.px + 1];
-    part.right = 4 < maze[player.py + 0][player.px - 1];
-    break;
-  case West:
-    part.blocked = 8 < maze[player.py + 0][player.px - 1];
-    part.front = 4 < maze[player.py + 0][player.px - 1];
-    part.left = 4 < maze[player.py + 1][player.px + 0];
-    part.right = 4 < maze[player.py - 1][player.px + 0];
-    break;
-  case East:
-    part.blocked = 8 < maze[player.py + 0][player.px + 1];
-    part.front = 4 < maze[player.py + 0][player.px + 1];
-    part.left = 4 < maze[player.py - 1][player.px + 0];
-    part.right = 4 < maze[player.py + 1][player.px + 0];
-    break;
-  default:
-    part.blocked = true;
-    break;
+    auto const& info = sPackTiles.info ();
+    maze.reset (&sPackTiles);
+    game.sx = info.sx;
+    game.sy = info.sy;
+    game.sd = static_cast<Direction> (info.sd & 3);
+    game.ex = info.ex;
+    game.ey = info.ey;
   }
-  return part;
+  else
+  {
+    maze.reset (&sGeneratedTiles);
+    game.sx = 1;
+    game.sy = 1;
+    game.ex = maze.width () - 2;
+    game.ey = maze.height () - 2;
+    game.sd = getOpenDirection (maze, game.sx, game.sy);
+  }
+
+  maze.prefetch (game.sx, game.sy);
+}
+
+#else
+
+bool isValid (BitMaze const& maze, maze::Endpoints const& ends)
+{
+  maze::heap::Scope const scratch (maze::heap::TagValidate);
+  return maze::validate (maze, ends.sx, ends.sy, ends.ex, ends.ey).valid ();
+}
+
+void loadLevel (Maze& maze, DistanceField& distance, Game& game)
+{
+  maze::heap::Scope const level (maze::heap::TagLevel);
+  maze::LevelPack const pack (maze::sLevelPack);
+
+  if (Packed == sLevelSource && pack.valid () && sPackedLevel < pack.count ())
+  {
+    auto const info = pack.info (sPackedLevel);
+    pack.load (sPackedLevel, maze);
+    game.sx = info.sx;
+    game.sy = info.sy;
+    game.sd = static_cast<Direction> (info.sd & 3);
+    game.ex = info.ex;
+    game.ey = info.ey;
+  }
+  else if (Generated == sLevelSource)
+  {
+    maze::GeneratorConfig config;
+    config.seed = sLevelSeed;
+    config.width = sGeneratedSize;
+    config.height = sGeneratedSize;
+
+    auto ends = maze::generate (maze, distance, config);
+    for (uint32_t attempt = 1; attempt < sGenerateAttempts && !isValid (maze, ends); ++attempt)
+    {
+      config.seed += 1;
+      ends = maze::generate (maze, distance, config);
+    }
+    game.sx = ends.sx;
+    game.sy = ends.sy;
+    game.ex = ends.ex;
+    game.ey = ends.ey;
+    game.sd = getOpenDirection (maze, game.sx, game.sy);
+  }
+  else
+    maze.assignBits (sLevelBits.words, sLevel.width (), sLevel.height ());
+
+  maze::heap::Scope const field (maze::heap::TagDistance);
+  distance.compute (maze, game.ex, game.ey);
 }
 
-// manhattan distance between player position and goal normalized by maximum manhattan distance
-float getDistanceNorm (Maze const &maze, Player const &player)
+#endif
+
+// Loads the tiles the next steps need, after the current step is shown
+#if MAZE_TILED_WORLD
+void prefetch (maze::TileCache& maze, Player const& player)
 {
-  auto const max = (maze.front ().size () - 2) + (maze.size () - 2);
-  auto const manhattan = std::abs (sGame.ex - player.px) + std::abs (sGame.ey - player.py);
+  maze.prefetch (player.px, player.py);
+}
+#else
+void prefetch (BitMaze const&, Player const&)
+{
+}
+#endif
 
-  return static_cast<float> (manhattan) / static_cast<float> (max);
+// walking distance between player position and goal normalized by maximum walking distance, Q16
+uint32_t getDistanceNorm (DistanceField const &distance, Player const &player)
+{
+#if MAZE_TILED_WORLD
+  (void) distance;
+  uint32_t const manhattan = std::abs (sGame.ex - player.px) + std::abs (sGame.ey - player.py);
+  return maze::pulse::rangeNorm (manhattan, sTiledPulseRange);
+#else
+  return maze::pulse::walkNorm (distance.at (player.px, player.py), distance.maximum ());
+#endif
 }
 
+// Full scale pulse colour per direction
+uint8_t const sDirectionRgb [4][3] = {
+  {0, sRGB, 0},    // North: Earth - green / coins
+  {sRGB, sRGB, 0}, // East: Air - yellow / swords
+  {sRGB, 0, 0},    // South: Fire - red / wands
+  {0, 0, sRGB}     // West: Water - blue / cups
+};
+
 void
-updateFloor (struct Floor& floor, Player& player, Maze const &maze)
+updateFloor (struct Floor& floor,
+             Player& player,
+             Maze const &maze,
+             DistanceField const &distance)
 {
   // default brightness
   floor.brightness = 20;
 
-  switch (maze [player.py][player.px])
-  {
-  case 2:
+  if (maze.test (LayerDark, player.px, player.py))
     floor.brightness = 1;
-    break;
-  case 3:
+  else if (maze.test (LayerTwister, player.px, player.py))
+  {
     Direction newDi;
     do
     {
@@ -166,66 +418,64 @@ updateFloor (struct Floor& floor, Player& player, Maze const &maze)
     }
     while (newDi == player.di);
     player.di = newDi;
-    break;
   }
 
-  switch (player.di)
-  {
-  case North:
-    // Earth - green / coins
-    floor.rgb = std::make_tuple (0.f, 1.f, 0.f);
-    break;
-  case East:
-    // Air - yellow / swords
-    floor.rgb = std::make_tuple (1.f, 1.f, 0.f);
-    break;
-  case South:
-    // Fire - red / wands
-    floor.rgb = std::make_tuple (1.f, 0.f, 0.f);
-    break;
-  case West:
-    // Water - blue / cups
-    floor.rgb = std::make_tuple (0.f, 0.f, 1.f);
-    break;
-  }
+  auto const& rgb = sDirectionRgb [player.di & 3];
+  floor.rgb = std::make_tuple (rgb [0], rgb [1], rgb [2]);
   
-  // relative time between two rgb led pulses: the shorter the nearer to the goal, can be 0.f
-  floor.pulse = getDistanceNorm (maze, player);
+  // relative time between two rgb led pulses: the shorter the nearer to the goal, can be 0
+  floor.pulse = getDistanceNorm (distance, player);
+  MicroBitEvent (sMazeEventId, sMazeEvtFloor);
 }
 
-using Color = std::tuple<uint8_t, uint8_t, uint8_t>;
-Color getScaled (Colorf const &color, float const intensity, uint8_t const rgbMax)
+// intensity in Q16
+Color getScaled (Color const &color, uint32_t const intensity)
 {
   return std::make_tuple (
-    static_cast<uint8_t> (std::get<0> (color) * intensity * static_cast<float> (rgbMax)),
-    static_cast<uint8_t> (std::get<1> (color) * intensity * static_cast<float> (rgbMax)),
-    static_cast<uint8_t> (std::get<2> (color) * intensity * static_cast<float> (rgbMax))
+    static_cast<uint8_t> ((std::get<0> (color) * intensity) >> 16),
+    static_cast<uint8_t> ((std::get<1> (color) * intensity) >> 16),
+    static_cast<uint8_t> ((std::get<2> (color) * intensity) >> 16)
   );
 }
 
-void
-updatePulse (struct Floor& floor, float const pulseResolution)
+// Sets the rgb led for the current time if its colour changed and returns
+// the time in ms until the next brightness step or pulse start is due, 0
+// if the colour stays until the floor changes
+unsigned long
+updatePulse (struct Floor& floor)
 {
-  uint8_t r, g, b;
-  auto const maxPulse = floor.pulse * sSlowestPulse;
+  Color color;
+  unsigned long delay = 0;
+  auto const length = maze::pulse::length (floor.pulse);
+  auto const time = uBit.systemTime ();
 
-  if (maxPulse < pulseResolution)
+  if (0 == length)
   {
-    floor.lastPulseStart = uBit.systemTime ();
-    r = g = b = sRGB;
+    // constant colour, only a move can change it
+    floor.lastPulseStart = time;
+    color = std::make_tuple (sRGB, sRGB, sRGB);
   }
   else
   {
-    auto const time = uBit.systemTime ();
-    if (static_cast<float> (time - floor.lastPulseStart) > maxPulse)
+    if (time - floor.lastPulseStart > length)
       floor.lastPulseStart = time;
 
-    auto const intensity = (1.f - floor.pulse) * static_cast<float> (time - floor.lastPulseStart) / maxPulse;
-    std::tie (r, g, b) = getScaled (floor.rgb, intensity, sRGB);
+    uint32_t const elapsed = time - floor.lastPulseStart;
+    auto const sample = maze::pulse::sample (floor.pulse, length, elapsed, sRGB);
+    color = getScaled (floor.rgb, sample.intensity);
+    delay = (sample.wait < sMaxPulseSleep) ? sample.wait : sMaxPulseSleep;
+  }
+
+  if (color != floor.shown)
+  {
+    uint8_t r, g, b;
+    std::tie (r, g, b) = color;
+    uBit.rgb.setColour (r, g, b, 0);
+    floor.shown = color;
+    sPulseStats.colourChanges += 1;
   }
 
-  uBit.rgb.setColour (r, g, b, 0);
-  uBit.sleep (pulseResolution /*ms*/);
+  return delay;
 }
 
 void move (Player &player)
@@ -258,56 +508,20 @@ void tilt (MicroBitImage &image)
   }
 }
 
-void setLeft (MicroBitImage &img, bool fill)
-{
-  img.setPixelValue (0, 0, sDI);
-  img.setPixelValue (0, 4, sDI);
-  if (fill)
-    for (int i = 1; i < 4; ++i)
-      img.setPixelValue (0, i, sDI);
-}
-
-void setRight (MicroBitImage &img, bool fill)
-{
-  img.setPixelValue (4, 0, sDI);
-  img.setPixelValue (4, 4, sDI);
-  if (fill)
-    for (int i = 1; i < 4; ++i)
-      img.setPixelValue (4, i, sDI);
-}
-
-void setMiddle (MicroBitImage &img, bool fill)
-{
-  for (int i = 1; i < 4; ++i)
-  {
-    img.setPixelValue (i, 1, sDI);
-    img.setPixelValue (i, 3, sDI);
-  }
-  img.setPixelValue (1, 2, sDI);
-  img.setPixelValue (3, 2, sDI);
-  if (fill)
-    img.setPixelValue (2, 2, sDI);
-}
-
 void updateImage (
   MicroBitImage& image,
   Maze const& maze,
   Player const& player)
 {
-  image.clear ();
-  auto const part = getMazePart (maze, player);
-  setLeft (image, part.left);
-  setMiddle (image, part.front);
-  setRight (image, part.right);
+  maze::render (image.getBitmap (), maze, sFog ? &sExplored : nullptr, player.px, player.py, player.di, sRace);
 }
 
 void
-updateVisuals (MicroBitImage& image,
-               struct Floor& floor,
-               Player& player,
-               Maze const& maze)
+showFloor (MicroBitImage& image,
+           struct Floor const& floor,
+           Player const& player,
+           Maze const& maze)
 {
-  updateFloor (floor, player, maze);
   updateImage (
     image,
     maze,
@@ -318,203 +532,625 @@ updateVisuals (MicroBitImage& image,
   uBit.display.print (image);
 }
 
-int modulo4 (int v)
+void
+updateVisuals (MicroBitImage& image,
+               struct Floor& floor,
+               Player& player,
+               Maze const& maze,
+               DistanceField const& distance)
 {
-  int constexpr mod = 4;
-  if (v >= mod)
-    return v - mod;
-  else if (v < 0)
-    return v + mod;
-  else
-    return v;
+  MAZE_PROFILE_SCOPE (SiteUpdateVisuals);
+  updateFloor (floor, player, maze, distance);
+  showFloor (image, floor, player, maze);
 }
 
 void playForwardSound ()
 {
-  uBit.soundmotor.soundOn (70);
-  uBit.sleep (50);
-  uBit.soundmotor.soundOff ();
-  uBit.sleep (50);
-  uBit.soundmotor.soundOn (70);
-  uBit.sleep (50);
-  uBit.soundmotor.soundOff ();
+  using maze::melody::Tone;
+  using maze::melody::br;
+
+  static Tone const sound [] = {
+    { 70, 50 },
+    { br, 50 },
+    { 70, 50 }
+  };
+  maze::sound::play (sound);
 }
 
 void playTurnAroundSound ()
 {
-  uBit.soundmotor.soundOn (100);
-  uBit.sleep (150);
-  uBit.soundmotor.soundOff ();
+  using maze::melody::Tone;
+
+  static Tone const sound [] = {
+    { 100, 150 }
+  };
+  maze::sound::play (sound);
 }
 
-void left (MicroBitEvent)
+// 0: no end
+// 1: victory
+// 2: death
+uint8_t
+isTheEnd (Game const& game, Player const& player, Maze const& maze)
 {
-  if (Floor != sPlayer.mode)
-    return;
+  if (maze.test (LayerTrap, player.px, player.py))
+    return 2;
+  if (game.ex == player.px &&
+      game.ey == player.py)
+    return 1;
+  return 0;
+}
 
-  sPlayer.di = static_cast<Direction> (modulo4 (sPlayer.di - 1));
+uint8_t sEnd = 0;
 
-  playTurnAroundSound ();
-  updateVisuals (sScreen, sFloor, sPlayer, sMaze);
+void checkEnd ()
+{
+  sEnd = isTheEnd (sGame, sPlayer, sMaze);
+  if (0 != sEnd)
+  {
+    MicroBitEvent (sMazeEventId, sMazeEvtEnd);
+    MicroBitEvent (sMazeEventId, sMazeEvtFloor);
+  }
 }
 
-void right (MicroBitEvent)
+#if MAZE_DYNAMIC_WALLS
+
+bool sDoorsOpen [sDoorCount];
+bool sTimedWallsClosed [sTimedWallCount];
+unsigned long sTimedWallsDue [sTimedWallCount];
+
+// Only the hand made level has the changing cells
+bool hasDynamicWalls ()
 {
-  if (Floor != sPlayer.mode)
-    return;
+  return HandMade == sLevelSource;
+}
 
-  sPlayer.di = static_cast<Direction> (modulo4 (sPlayer.di + 1));
+// A bit per open door
+uint8_t getDoorBits ()
+{
+  uint8_t bits = 0;
+  for (size_t i = 0; i < sDoorCount; ++i)
+    if (sDoorsOpen [i])
+      bits |= 1 << i;
+  return bits;
+}
 
-  playTurnAroundSound ();
-  updateVisuals (sScreen, sFloor, sPlayer, sMaze);
+// A bit per closed timed wall
+uint8_t getTimedWallBits ()
+{
+  uint8_t bits = 0;
+  for (size_t i = 0; i < sTimedWallCount; ++i)
+    if (sTimedWallsClosed [i])
+      bits |= 1 << i;
+  return bits;
 }
 
-void forward (MicroBitEvent)
+void saveWalls ()
 {
-  if (Floor != sPlayer.mode)
-    return;
+  maze::save::recordWalls (getDoorBits (), getTimedWallBits ());
+}
 
-  auto const mazePart = getMazePart (sMaze, sPlayer);
-  if (mazePart.blocked)
+// Sets a cell of the running level, the distances and the pulse follow
+void changeTile (int32_t const x, int32_t const y, uint8_t const tile)
+{
+  sMaze.setTile (x, y, tile);
+  maze::heap::Scope const repair (maze::heap::TagDistance);
+  sDistance.update (sMaze, x, y);
+  sFloor.pulse = getDistanceNorm (sDistance, sPlayer);
+}
+
+// The level was loaded again with all doors closed and timed walls open
+void resetWalls ()
+{
+  for (auto& open : sDoorsOpen)
+    open = false;
+  for (size_t i = 0; i < sTimedWallCount; ++i)
   {
-    tilt (sScreen);
-    return;
+    sTimedWallsClosed [i] = false;
+    sTimedWallsDue [i] = uBit.systemTime () + sTimedWalls [i].period;
   }
+}
 
-  move (sPlayer);
+// Opens and closes the changing walls as they were saved
+void restoreWalls (uint8_t const doors, uint8_t const walls)
+{
+  for (size_t i = 0; i < sDoorCount; ++i)
+    if (doors & (1 << i))
+    {
+      sDoorsOpen [i] = true;
+      changeTile (sDoors [i].x, sDoors [i].y, 0);
+    }
+  for (size_t i = 0; i < sTimedWallCount; ++i)
+    if (walls & (1 << i))
+    {
+      sTimedWallsClosed [i] = true;
+      changeTile (sTimedWalls [i].x, sTimedWalls [i].y, 9);
+    }
+}
+
+void pullLever (Player const& player)
+{
+  if (!hasDynamicWalls ())
+    return;
+
+  for (size_t i = 0; i < sDoorCount; ++i)
+    if (!sDoorsOpen [i] && player.px == sDoors [i].leverX && player.py == sDoors [i].leverY)
+    {
+      sDoorsOpen [i] = true;
+      changeTile (sDoors [i].x, sDoors [i].y, 0);
+      saveWalls ();
+    }
+}
+
+#endif
 
-  playForwardSound ();
-  updateVisuals (sScreen, sFloor, sPlayer, sMaze);
+maze::save::State getSaveState (Player const& player)
+{
+  maze::save::State state;
+  state.source = sLevelSource;
+  state.level = sPackedLevel;
+  state.seed = sLevelSeed;
+  state.px = player.px;
+  state.py = player.py;
+  state.di = player.di;
+  state.mode = player.mode;
+#if MAZE_DYNAMIC_WALLS
+  state.doors = getDoorBits ();
+  state.walls = getTimedWallBits ();
+#endif
+  return state;
 }
 
-MicroBitImage
-getMap (Maze const& maze)
+// The view after a saved move was seen, a batch of steps showed fewer
+void exploreSaved (maze::save::State const& state)
 {
-  auto const mazeSizeX = maze.front ().size ();
-  auto const mazeSizeY = maze.size ();
+  if (sFog)
+    maze::explore (sExplored, maze::getView (sMaze, state.px, state.py, state.di), state.px, state.py, state.di);
+}
 
-  // Clear new map with 1
-  // increase by 1 in each direction to show walls on the display outside
-  // the play area to not confuse the player
-  std::vector<uint8_t> const data ((mazeSizeX + 2) * (mazeSizeY * 2), sDI);
-  MicroBitImage map (
-    mazeSizeX + 2,
-    mazeSizeY + 2,
-    data.data ()
-  );
+// Continues a game saved for the same level that has not ended yet
+void resume (Player& player)
+{
+  maze::save::State saved;
+  if (!maze::save::load (saved))
+    return;
 
-  for (size_t x = 0; x < maze.front ().size (); ++x)
-    for (size_t y = 0; y < maze.size (); ++y)
-      if (maze [y][x] < 5)
-        map.setPixelValue (x + 1, y + 1, 0);
+  auto const current = getSaveState (player);
+  if (saved.source != current.source ||
+      saved.level != current.level ||
+      saved.seed != current.seed)
+    return;
 
-  return map;
+  Player resumed = player;
+  resumed.px = saved.px;
+  resumed.py = saved.py;
+  resumed.di = static_cast<Direction> (saved.di & 3);
+  // always continue in the floor view
+  resumed.mode = Floor;
+  if (resumed.px <= 0 || resumed.py <= 0 ||
+      resumed.px >= sMaze.width () - 1 || resumed.py >= sMaze.height () - 1 ||
+      0 != isTheEnd (sGame, resumed, sMaze))
+    return;
+
+  player = resumed;
+#if MAZE_DYNAMIC_WALLS
+  if (hasDynamicWalls ())
+    restoreWalls (saved.doors, saved.walls);
+#endif
+  // the cells seen up to the snapshot and the views from there on
+  maze::save::load (saved, &sExplored, exploreSaved);
 }
 
-void printMap (MicroBitImage const& map, Player const& player)
+// Turns by the net quarter turns of several presses, false if they
+// cancel out
+bool applyTurns (int const quarters)
 {
-  // Do not use copy constructor or copy operator here
-  // No copy is generated in this case and the original
-  // image is shifted
-  MicroBitImage tmp = const_cast<MicroBitImage*> (&map)->clone ();
+  if (0 == (quarters & 3))
+    return false;
+
+  sPlayer.di = static_cast<Direction> ((sPlayer.di + quarters) & 3);
+  updateFloor (sFloor, sPlayer, sMaze, sDistance);
+  maze::save::record (false, 0, sPlayer.di, sPlayer.mode);
+  sRace.turn (sPlayer.di);
+  return true;
+}
 
-  // shift left and up
-  // +2 because of border,
-  // -2 because of display center
-  // -1 because sMaze is one smaller in each direction than map
-  tmp.shiftLeft (player.px + 2 - 2 - 1);
-  tmp.shiftUp (player.py + 2 - 2 - 1);
+// One step forward, false if a wall is in the way
+bool applyStep ()
+{
+  if (getMazePart (sMaze, sPlayer).blocked)
+    return false;
 
-  uBit.display.print (tmp);
+  // a twister changes the direction after the step
+  auto const moveDi = sPlayer.di;
+  move (sPlayer);
+  // several steps are shown at once, the cells in between were walked on
+  if (sFog)
+    sExplored.mark (sPlayer.px, sPlayer.py);
+#if MAZE_DYNAMIC_WALLS
+  pullLever (sPlayer);
+#endif
+  updateFloor (sFloor, sPlayer, sMaze, sDistance);
+  maze::save::record (true, moveDi, sPlayer.di, sPlayer.mode);
+  sRace.step (moveDi, sPlayer.di);
+  checkEnd ();
+  prefetch (sMaze, sPlayer);
+  return true;
+}
+
+// Copies the seen walls of the 5x5 cells around the player into the view
+void printMap (MicroBitImage& view, Maze const& maze, Player const& player)
+{
+  maze::drawMap (view.getBitmap (), maze, sFog ? &sExplored : nullptr, player.px, player.py, sRace);
+  uBit.display.print (view);
 }
 
-void toggleMap (MicroBitEvent)
+// Redraws the current view without touching the floor state
+void showView ()
 {
   if (Floor == sPlayer.mode)
   {
-    sPlayer.mode = Map;
-    printMap (sMap, sPlayer);
+    updateImage (sScreen, sMaze, sPlayer);
+    uBit.display.print (sScreen);
   }
   else
+    printMap (sMapView, sMaze, sPlayer);
+}
+
+void receiveGhosts (MicroBitEvent)
+{
+  if (0 == sEnd && sRace.receive (uBit.systemTime ()))
+    showView ();
+}
+
+// Inputs queued by the event handlers, applied by the game fiber
+maze::input::Queue sInputs;
+bool volatile sInputWaiting = false;
+
+// Runs where the event is raised, maybe in an interrupt: only queues the
+// input and wakes the game fiber if it waits for one
+void queueInput (MicroBitEvent e)
+{
+  using namespace maze::latency;
+
+  Handler kind;
+  switch (e.source)
   {
-    sPlayer.mode = Floor;
-    uBit.display.print (sScreen);
+  case MICROBIT_ID_BUTTON_A:
+    kind = Left;
+    break;
+  case MICROBIT_ID_BUTTON_B:
+    kind = Right;
+    break;
+  case MICROBIT_ID_BUTTON_AB:
+    kind = Forward;
+    break;
+  case MICROBIT_ID_GESTURE:
+    kind = ToggleMap;
+    break;
+  default:
+    return;
+  }
+
+  received (kind);
+  sInputs.push (kind, static_cast<uint32_t> (e.timestamp));
+  if (sInputWaiting)
+  {
+    sInputWaiting = false;
+    MicroBitEvent (sMazeEventId, sMazeEvtInput);
+  }
+}
+
+// Event time of a queued input from its low 32 bits
+uint64_t getEventTime (maze::input::Input const& input, uint64_t const now)
+{
+  return now - static_cast<uint32_t> (static_cast<uint32_t> (now) - input.time);
+}
+
+// Applies the queued inputs in order and shows only the final state.
+// The turns between two other inputs count as their net turn, every step
+// is taken on its own with its twister, trap and save record.
+void applyInputs ()
+{
+  using namespace maze::latency;
+
+  maze::input::Input batch [maze::input::sCapacity];
+  uint8_t count = 0;
+  int quarters = 0;
+  bool turned = false;
+  bool moved = false;
+  bool bumped = false;
+  bool toggled = false;
+
+  while (0 == sEnd && count < maze::input::sCapacity && sInputs.pop (batch [count]))
+  {
+    auto const& input = batch [count++];
+    if (ToggleMap == input.kind)
+    {
+      turned = applyTurns (quarters) || turned;
+      quarters = 0;
+      sPlayer.mode = (Floor == sPlayer.mode) ? Map : Floor;
+      maze::save::record (false, 0, sPlayer.di, sPlayer.mode);
+      toggled = true;
+    }
+    // the map view ignores turns and steps
+    else if (Floor == sPlayer.mode)
+    {
+      if (Left == input.kind)
+        quarters -= 1;
+      else if (Right == input.kind)
+        quarters += 1;
+      else
+      {
+        turned = applyTurns (quarters) || turned;
+        quarters = 0;
+        if (applyStep ())
+          moved = true;
+        else
+          bumped = true;
+      }
+    }
+    logic (input.kind, getEventTime (input, system_timer_current_time_us ()));
+  }
+  turned = applyTurns (quarters) || turned;
+
+  if (moved)
+    playForwardSound ();
+  else if (turned)
+    playTurnAroundSound ();
+
+  if (Map == sPlayer.mode)
+  {
+    if (toggled)
+      printMap (sMapView, sMaze, sPlayer);
+  }
+  else
+  {
+    if (moved || turned || toggled)
+      showFloor (sScreen, sFloor, sPlayer, sMaze);
+    if (bumped)
+      tilt (sScreen);
+  }
+
+  auto const now = system_timer_current_time_us ();
+  for (uint8_t i = 0; i < count; ++i)
+    output (batch [i].kind, getEventTime (batch [i], now));
+}
+
+// The game fiber, applies the inputs until the game ends
+void play ()
+{
+  while (0 == sEnd)
+  {
+    // registered for the wake up before the interrupts are on again, an
+    // input queued after the check can not get lost
+    __disable_irq ();
+    auto const idle = sInputs.empty ();
+    if (idle)
+    {
+      sInputWaiting = true;
+      fiber_wake_on_event (sMazeEventId, sMazeEvtInput);
+    }
+    __enable_irq ();
+
+    if (idle)
+      schedule ();
+    else
+      applyInputs ();
   }
 }
 
+void printLatency (MicroBitEvent)
+{
+  maze::latency::print ();
+}
+
 void init ()
 {
-  // button A == left
+  // all inputs go into the queue of the game fiber:
+  // button A == left, button B == right, both == forward, shake == map
   uBit.messageBus.listen (
     MICROBIT_ID_BUTTON_A,
     MICROBIT_BUTTON_EVT_CLICK,
-    left,
-    MESSAGE_BUS_LISTENER_DROP_IF_BUSY
+    queueInput,
+    MESSAGE_BUS_LISTENER_IMMEDIATE
   );
-  // button B == left
   uBit.messageBus.listen (
     MICROBIT_ID_BUTTON_B,
     MICROBIT_BUTTON_EVT_CLICK,
-    right,
-    MESSAGE_BUS_LISTENER_DROP_IF_BUSY
+    queueInput,
+    MESSAGE_BUS_LISTENER_IMMEDIATE
   );
-  // button AB == forward
   uBit.messageBus.listen (
     MICROBIT_ID_BUTTON_AB,
     MICROBIT_BUTTON_EVT_CLICK,
-    forward,
-    MESSAGE_BUS_LISTENER_DROP_IF_BUSY
+    queueInput,
+    MESSAGE_BUS_LISTENER_IMMEDIATE
   );
-  // map mode
   uBit.messageBus.listen (
     MICROBIT_ID_GESTURE,
     MICROBIT_ACCELEROMETER_EVT_SHAKE,
-    toggleMap,
+    queueInput,
+    MESSAGE_BUS_LISTENER_IMMEDIATE
+  );
+  // long press of A and B dumps the latencies over serial
+  uBit.messageBus.listen (
+    MICROBIT_ID_BUTTON_AB,
+    MICROBIT_BUTTON_EVT_LONG_CLICK,
+    printLatency
+  );
+  // ghost race packets, the race fiber picks up the ones dropped here
+  uBit.messageBus.listen (
+    MICROBIT_ID_RADIO,
+    MICROBIT_RADIO_EVT_DATAGRAM,
+    receiveGhosts,
     MESSAGE_BUS_LISTENER_DROP_IF_BUSY
   );
 }
 
 void cleanup ()
 {
-  // button A == left
   uBit.messageBus.ignore (
     MICROBIT_ID_BUTTON_A,
     MICROBIT_BUTTON_EVT_CLICK,
-    left
+    queueInput
   );
-  // button B == left
   uBit.messageBus.ignore (
     MICROBIT_ID_BUTTON_B,
     MICROBIT_BUTTON_EVT_CLICK,
-    right
+    queueInput
   );
-  // button AB == forward
   uBit.messageBus.ignore (
     MICROBIT_ID_BUTTON_AB,
     MICROBIT_BUTTON_EVT_CLICK,
-    forward
+    queueInput
   );
-  // map mode
   uBit.messageBus.ignore (
     MICROBIT_ID_GESTURE,
     MICROBIT_ACCELEROMETER_EVT_SHAKE,
-    toggleMap
+    queueInput
+  );
+  uBit.messageBus.ignore (
+    MICROBIT_ID_BUTTON_AB,
+    MICROBIT_BUTTON_EVT_LONG_CLICK,
+    printLatency
+  );
+  uBit.messageBus.ignore (
+    MICROBIT_ID_RADIO,
+    MICROBIT_RADIO_EVT_DATAGRAM,
+    receiveGhosts
   );
 }
 
-// 0: no end
-// 1: victory
-// 2: death
-uint8_t
-isTheEnd (Game const& game, Player const& player, Maze const& maze)
+bool sPulseActive = false;
+
+// Wakes up only when the rgb led has to change: for the next step of a
+// pulse, else when the floor changes
+void pulseLed ()
 {
-  auto const field = maze [player.py][player.px];
-  if (1 == field)
-    return 2;
-  if (game.ex == player.px &&
-      game.ey == player.py)
-    return 1;
-  return 0;
+  while (0 == sEnd)
+  {
+    auto const begin = system_timer_current_time_us ();
+    auto const delay = updatePulse (sFloor);
+    sPulseStats.wakeups += 1;
+    sPulseStats.busyUs += system_timer_current_time_us () - begin;
+
+    if (0 == delay)
+      fiber_wait_for_event (sMazeEventId, sMazeEvtFloor);
+    else
+      uBit.sleep (delay);
+  }
+
+  sPulseActive = false;
+  MicroBitEvent (sMazeEventId, sMazeEvtDone);
+}
+
+bool sGhostsActive = false;
+
+// Sends the own moves in batches and drops the ghosts gone quiet
+void raceGhosts ()
+{
+  while (0 == sEnd)
+  {
+    auto const now = uBit.systemTime ();
+    sRace.send (now);
+    auto changed = sRace.receive (now);
+    changed = sRace.expire (now) || changed;
+    if (changed)
+      showView ();
+
+    uBit.sleep (maze::ghost::sBatchInterval);
+  }
+
+  // the others see the end with a last key
+  sRace.end (sEnd);
+  sRace.send (uBit.systemTime ());
+  sGhostsActive = false;
+  MicroBitEvent (sMazeEventId, sMazeEvtDone);
+}
+
+// Counts the games, a fiber of an ended game may still sleep when the
+// next one starts
+uint32_t sGameNumber = 0;
+
+#if MAZE_DYNAMIC_WALLS
+
+// Toggles the timed walls when they are due and sleeps until the next
+// one, it notices the end when it wakes up
+void toggleWalls ()
+{
+  auto const game = sGameNumber;
+  while (0 == sEnd && game == sGameNumber)
+  {
+    auto const now = uBit.systemTime ();
+    auto delay = ~0ul;
+    bool changed = false;
+    for (size_t i = 0; i < sTimedWallCount; ++i)
+    {
+      auto const& wall = sTimedWalls [i];
+      if (now >= sTimedWallsDue [i])
+      {
+        // the player is never walled in, the wall waits a period
+        auto const occupied = sPlayer.px == wall.x && sPlayer.py == wall.y;
+        if (!occupied)
+        {
+          sTimedWallsClosed [i] = !sTimedWallsClosed [i];
+          changeTile (wall.x, wall.y, sTimedWallsClosed [i] ? 9 : 0);
+          saveWalls ();
+          changed = true;
+        }
+        sTimedWallsDue [i] = now + wall.period;
+      }
+      if (sTimedWallsDue [i] - now < delay)
+        delay = sTimedWallsDue [i] - now;
+    }
+    if (changed)
+      showView ();
+
+    uBit.sleep (delay);
+  }
+}
+
+#endif
+
+// Each device gets its own ghost id
+uint16_t getGhostId ()
+{
+  auto const serial = microbit_serial_number ();
+  return static_cast<uint16_t> (serial ^ (serial >> 16));
+}
+
+// Ghosts of other levels are ignored
+uint16_t getLevelId (maze::save::State const& state)
+{
+  auto const mix = (state.seed * 2654435761u) ^ (static_cast<uint32_t> (state.level) << 8) ^ state.source;
+  return static_cast<uint16_t> (mix ^ (mix >> 16));
+}
+
+void printGhostStats (maze::ghost::Race::Stats const& stats)
+{
+  uBit.serial.printf ("ghosts: %lu keys, %lu deltas, %lu bytes sent, %lu received, %lu gaps\r\n",
+                      static_cast<unsigned long> (stats.keys),
+                      static_cast<unsigned long> (stats.deltas),
+                      static_cast<unsigned long> (stats.bytes),
+                      static_cast<unsigned long> (stats.received),
+                      static_cast<unsigned long> (stats.gaps));
+}
+
+void printPulseStats (PulseStats const& stats)
+{
+  uBit.serial.printf ("pulse wakeups: %lu, colour changes: %lu, busy: %lu us\r\n",
+                      static_cast<unsigned long> (stats.wakeups),
+                      static_cast<unsigned long> (stats.colourChanges),
+                      static_cast<unsigned long> (stats.busyUs));
+}
+
+void printLevel ()
+{
+  if (HandMade == sLevelSource)
+    uBit.serial.printf ("level: %dx%d, %d walls, %d secret walls\r\n",
+                        static_cast<int> (sLevel.width ()), static_cast<int> (sLevel.height ()),
+                        static_cast<int> (sLevelWalls), static_cast<int> (sLevelSecrets));
 }
 
 void startScrolling (bool& active, std::string const& text, int const delay)
@@ -555,7 +1191,7 @@ void playTitleMelody ()
 {
   using namespace maze::melody;
 
-  Melody m = {
+  static Tone const m [] = {
     { c1, t1 },
     { c1, t1 },
     { br, t8 },
@@ -573,7 +1209,8 @@ void playTitleMelody ()
     { c1, t1 }
   };
 
-  play (uBit, m);
+  maze::sound::play (m, legato);
+  maze::sound::wait ();
 }
 
 
@@ -584,51 +1221,61 @@ namespace maze
 
 bool titleActive = false;
 
-void setBrightness (MicroBitImage& img, uint8_t const brightness)
+// Column x of the text when rendered with 5 pixel wide characters,
+// bit y set if pixel (x, y) is lit
+uint8_t textColumn (MicroBitFont const& font, char const* text, size_t const length, size_t const x)
 {
-  auto* dataPtr = img.getBitmap ();
-  for (int i = 0; i < img.getSize (); ++i)
-    if (dataPtr [i] > 0)
-      dataPtr [i] = brightness;
+  auto const c = (x / 5 < length) ? text [x / 5] : ' ';
+  if (c < MICROBIT_FONT_ASCII_START || c > font.asciiEnd)
+    return 0;
+
+  auto const* glyph = font.characters + (c - MICROBIT_FONT_ASCII_START) * MICROBIT_FONT_HEIGHT;
+  auto const mask = 0x10 >> (x % 5);
+  uint8_t column = 0;
+  for (int y = 0; y < MICROBIT_FONT_HEIGHT; ++y)
+    if (glyph [y] & mask)
+      column |= 1 << y;
+  return column;
 }
 
-MicroBitImage createImage (std::string const& text)
+void showTitle ()
 {
-  MicroBitImage img (text.size () * 5, 5);
-  int x = 0;
-  for (auto const c : text)
-  {
-    img.print (c, x, 0);
-    x += 5;
-  }
+  static char const text [] = " MiniMaze0.92 ";
+  auto const length = sizeof (text) - 1;
+  auto const font = uBit.display.getFont ();
 
-  return img;
-}
+  // the only frame buffer, reused for every frame
+  static MicroBitImage frame = arena::image (arena::SlotTitle, 5, 5);
+  auto* pixels = frame.getBitmap ();
 
-MicroBitImage createBackground (uint8_t const brightness)
-{
-  std::vector<uint8_t> const data (5 * 5, brightness);
-  return MicroBitImage (5, 5, data.data ());
-}
-
-void showTitle ()
-{
-  auto textImage = createImage (" MiniMaze0.92 ");
-  setBrightness (textImage, 62);
   uBit.display.setDisplayMode (DISPLAY_MODE_GREYSCALE);
 
   uint8_t brightness = 0;
-  for (int stride = 0; stride < textImage.getWidth (); ++stride)
+  auto next = uBit.systemTime ();
+  for (size_t stride = 0; stride < length * 5; ++stride)
   {
-    textImage.shiftLeft (1);
-
     for (int i = 0; i < 2; ++i)
     {
-      auto background = createBackground (brightness);
-      background.paste (textImage, 0, 0, 1);
-
-      uBit.display.print (background);
-      uBit.sleep (62);
+      // one frame, the pacing below is not timed
+      {
+        MAZE_PROFILE_SCOPE (SiteShowTitle);
+        memset (pixels, brightness, 5 * 5);
+        for (int x = 0; x < 5; ++x)
+        {
+          auto const column = textColumn (font, text, length, stride + 1 + x);
+          for (int y = 0; y < 5; ++y)
+            if (column & (1 << y))
+              pixels [y * 5 + x] = 62;
+        }
+
+        uBit.display.print (frame);
+      }
+
+      // pace by deadline so the melody fiber does not make the title drift
+      next += 62;
+      auto const now = uBit.systemTime ();
+      if (next > now)
+        uBit.sleep (next - now);
 
       brightness += 1;
       if (brightness > 15)
@@ -639,9 +1286,39 @@ void showTitle ()
   titleActive = false;
 }
 
+PulseStats const& pulseStats ()
+{
+  return sPulseStats;
+}
+
+PlayerState playerState ()
+{
+  PlayerState state;
+  state.px = sPlayer.px;
+  state.py = sPlayer.py;
+  state.di = static_cast<uint8_t> (sPlayer.di);
+  return state;
+}
+
+uint16_t safeDistance (int32_t const x, int32_t const y)
+{
+#if MAZE_TILED_WORLD
+  // no distance field
+  (void) x;
+  (void) y;
+  return sUnreachable;
+#else
+  if (sMaze.test (LayerTrap, x, y))
+    return sUnreachable;
+  return sDistance.at (x, y);
+#endif
+}
+
 void run ()
 {
+  ++sGameNumber;
   uBit.rgb.off ();
+  sound::start ();
 
   titleActive = true;
   create_fiber (showTitle);
@@ -649,33 +1326,91 @@ void run ()
   while (titleActive)
     uBit.sleep (50);
 
+  loadLevel (sMaze, sDistance, sGame);
+
+  sFog = sMaze.width () <= sMaxExplored && sMaze.height () <= sMaxExplored;
+  {
+    heap::Scope const explored (heap::TagExplored);
+    sExplored.reset (sFog ? sMaze.width () : 0, sFog ? sMaze.height () : 0);
+  }
+
   // Initialize player position and direction
   sPlayer.px = sGame.sx;
   sPlayer.py = sGame.sy;
   sPlayer.di = sGame.sd;
+  sPlayer.mode = Floor;
+
+#if MAZE_DYNAMIC_WALLS
+  resetWalls ();
+#endif
+  // continue after a power loss, then start a new save log
+  resume (sPlayer);
+  save::start (getSaveState (sPlayer), &sExplored);
 
   // Initialize floor led pulsing
   sFloor.lastPulseStart = uBit.systemTime ();
+  sFloor.shown = std::make_tuple (0, 0, 0);
+  sEnd = 0;
 
-  sScreen = MicroBitImage (5, 5);
-  sMap = getMap (sMaze);
+  sScreen = arena::image (arena::SlotScreen, 5, 5);
+  sMapView = arena::image (arena::SlotMap, 5, 5);
 
-  uBit.display.setDisplayMode (DISPLAY_MODE_BLACK_AND_WHITE);
-  updateVisuals (sScreen, sFloor, sPlayer, sMaze);
+  // the view shades walls by distance
+  uBit.display.setDisplayMode (DISPLAY_MODE_GREYSCALE);
+  updateVisuals (sScreen, sFloor, sPlayer, sMaze, sDistance);
 
+  // presses after the end of the last game are not for this one
+  sInputs.clear ();
+  sInputWaiting = false;
   init ();
 
-  uint8_t end;
-  do
+  sPulseStats = PulseStats ();
+  sPulseActive = true;
+  create_fiber (pulseLed);
+
+  if (MAZE_GHOST_RACE && sRadio.start (sGhostGroup))
+  {
+    maze::ghost::Position self;
+    self.px = sPlayer.px;
+    self.py = sPlayer.py;
+    self.di = sPlayer.di;
+    sRace.start (&sRadio, getGhostId (), getLevelId (getSaveState (sPlayer)), self, uBit.systemTime ());
+    sGhostsActive = true;
+    create_fiber (raceGhosts);
+  }
+
+#if MAZE_DYNAMIC_WALLS
+  if (hasDynamicWalls ())
   {
-    updatePulse (sFloor, sMinPulseResolution);
-    end = isTheEnd (sGame, sPlayer, sMaze);
+    // a resumed game may stand on a lever
+    pullLever (sPlayer);
+    create_fiber (toggleWalls);
   }
-  while (0 == end);
+#endif
+
+  create_fiber (play);
+
+  // raised by the game fiber
+  if (0 == sEnd)
+    fiber_wait_for_event (sMazeEventId, sMazeEvtEnd);
+  auto const end = sEnd;
+  save::clear ();
 
   uBit.sleep (500 /*ms*/);
+  while (sPulseActive || sGhostsActive)
+    fiber_wait_for_event (sMazeEventId, sMazeEvtDone);
   uBit.rgb.off ();
-
+  printPulseStats (sPulseStats);
+  if (sRace.started ())
+    printGhostStats (sRace.stats ());
+  printLevel ();
+  heap::print ();
+#if MAZE_PROFILE
+  profile::print ();
+#endif
+
+  // the icons and the text are drawn with brightness 1
+  uBit.display.setDisplayMode (DISPLAY_MODE_BLACK_AND_WHITE);
   uBit.display.clear ();
   uBit.display.print ((1 == end) ? *image (ImageSmiley) : *image (ImageSadly));
   uBit.sleep (800 /*ms*/);
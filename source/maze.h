@@ -1,6 +1,31 @@
 #pragma once
 
+#include <cstdint>
+
 namespace maze {
   void run ();
-}
 
+  // Whether the title still scrolls, run waits for it
+  extern bool titleActive;
+
+  // Cost of the rgb led pulse of the last game
+  struct PulseStats {
+    uint32_t wakeups = 0;
+    uint32_t colourChanges = 0;
+    uint64_t busyUs = 0;
+  };
+  PulseStats const& pulseStats ();
+
+  // Where the player of the running game stands, for the scripted player
+  // of the host tools. di: 0 north, then clockwise.
+  struct PlayerState {
+    int32_t px = 0;
+    int32_t py = 0;
+    uint8_t di = 0;
+  };
+  PlayerState playerState ();
+
+  // Walking distance of the cell next to the player to the goal, traps
+  // and cells off the walkable level read 0xffff
+  uint16_t safeDistance (int32_t x, int32_t y);
+}
@@ -0,0 +1,102 @@
+#include "profile.h"
+
+#if MAZE_PROFILE
+
+// only the device build targets 32 bit ARM
+#if defined (__arm__)
+#include <MicroBit.h>
+
+extern MicroBit uBit;
+#else
+#include <chrono>
+#include <cstdio>
+#endif
+
+namespace maze { namespace profile {
+
+namespace
+{
+
+Histogram sSites [SiteCount];
+
+char const* const sNames [SiteCount] = {
+  "updateVisuals", "render", "isBlocked", "pulse", "drawMap", "showTitle"
+};
+
+}
+
+#if defined (__arm__)
+
+uint64_t now ()
+{
+  return system_timer_current_time_us ();
+}
+
+void print ()
+{
+  for (int i = 0; i < SiteCount; ++i)
+  {
+    auto const& histogram = sSites [i];
+    uBit.serial.printf ("%s us: n %lu min %lu mean %lu p99 %lu max %lu\r\n",
+                        sNames [i],
+                        static_cast<unsigned long> (histogram.count ()),
+                        static_cast<unsigned long> (histogram.min ()),
+                        static_cast<unsigned long> (histogram.mean ()),
+                        static_cast<unsigned long> (histogram.percentile (99)),
+                        static_cast<unsigned long> (histogram.max ()));
+  }
+}
+
+#else
+
+uint64_t now ()
+{
+  using namespace std::chrono;
+  static auto const start = steady_clock::now ();
+  return static_cast<uint64_t> (duration_cast<nanoseconds> (steady_clock::now () - start).count ());
+}
+
+void print ()
+{
+  printf ("{\"unit\":\"ns\",\"sites\":[");
+  for (int i = 0; i < SiteCount; ++i)
+  {
+    auto const& histogram = sSites [i];
+    printf ("%s{\"name\":\"%s\",\"count\":%lu,\"min\":%lu,\"mean\":%lu,\"p99\":%lu,\"max\":%lu}",
+            (0 == i) ? "" : ",",
+            sNames [i],
+            static_cast<unsigned long> (histogram.count ()),
+            static_cast<unsigned long> (histogram.min ()),
+            static_cast<unsigned long> (histogram.mean ()),
+            static_cast<unsigned long> (histogram.percentile (99)),
+            static_cast<unsigned long> (histogram.max ()));
+  }
+  printf ("]}\n");
+}
+
+#endif
+
+void add (Site const site, uint32_t const ticks)
+{
+  sSites [site].add (ticks);
+}
+
+void reset ()
+{
+  for (auto& histogram : sSites)
+    histogram.reset ();
+}
+
+Histogram const& histogram (Site const site)
+{
+  return sSites [site];
+}
+
+char const* name (Site const site)
+{
+  return sNames [site];
+}
+
+}}
+
+#endif
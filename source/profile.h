@@ -0,0 +1,59 @@
+#pragma once
+
+#include "histogram.h"
+
+#include <cstdint>
+
+// 1: time the render, pulse and map paths, the game dumps them after its
+// other statistics over serial when it ends, the host profile with the
+// benchmarks. At 0 the timers and the table are not built at all.
+#ifndef MAZE_PROFILE
+#define MAZE_PROFILE 0
+#endif
+
+namespace maze { namespace profile {
+
+// Timed functions, each timer includes the sites it calls
+enum Site {
+  SiteUpdateVisuals = 0, SiteRender, SiteIsBlocked, SitePulse,
+  SiteDrawMap, SiteShowTitle, SiteCount
+};
+
+// Microseconds of the system timer on the device, nanoseconds of a
+// steady clock on the build host, where the views take less than a us
+uint64_t now ();
+
+void add (Site site, uint32_t ticks);
+void reset ();
+
+Histogram const& histogram (Site site);
+char const* name (Site site);
+
+// The device dumps the table over serial, the host writes it as one line
+// of JSON to stdout
+void print ();
+
+// Adds the time from construction to destruction to its site
+class Timer
+{
+public:
+  explicit Timer (Site const site) : mSite (site), mStart (now ()) {}
+  ~Timer () { add (mSite, static_cast<uint32_t> (now () - mStart)); }
+
+  Timer (Timer const&) = delete;
+  Timer& operator= (Timer const&) = delete;
+
+private:
+  Site mSite;
+  uint64_t mStart;
+};
+
+}}
+
+// Times the rest of the enclosing block, site is one of Site without the
+// namespace
+#if MAZE_PROFILE
+#define MAZE_PROFILE_SCOPE(site) maze::profile::Timer const profileTimer_ (maze::profile::site)
+#else
+#define MAZE_PROFILE_SCOPE(site) static_cast<void> (0)
+#endif
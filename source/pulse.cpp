@@ -0,0 +1,59 @@
+#include "pulse.h"
+
+namespace maze { namespace pulse {
+
+uint32_t walkNorm (uint32_t const walk, uint32_t const maximum)
+{
+  if (0 == maximum || walk > maximum)
+    return sQ16One;
+
+  return (walk << 16) / maximum;
+}
+
+uint32_t rangeNorm (uint32_t const manhattan, uint32_t const range)
+{
+  if (manhattan >= range)
+    return sQ16One;
+
+  return (manhattan << 16) / range;
+}
+
+uint32_t length (uint32_t const norm)
+{
+  auto const length = (norm * sSlowest) >> 16;
+  return (length < sMinResolution) ? 0 : length;
+}
+
+uint32_t intensity (uint32_t const norm, uint32_t const length, uint32_t const elapsed)
+{
+  // intensity at the end of the pulse
+  auto const peak = sQ16One - norm;
+  return peak * elapsed / length;
+}
+
+uint32_t wait (uint32_t const norm, uint32_t const length, uint32_t const elapsed, uint8_t const fullScale)
+{
+  // the next step of a full channel scaled from the intensity like the
+  // led colour, or the next pulse start
+  auto next = length + 1;
+  auto const peak = sQ16One - norm;
+  if (peak > 0 && fullScale > 0)
+  {
+    auto const level = fullScale * intensity (norm, length, elapsed) >> 16;
+    // lowest intensity of the next level and the first ms reaching it
+    auto const needed = (((level + 1) << 16) + fullScale - 1) / fullScale;
+    auto const step = (needed * length + peak - 1) / peak;
+    if (step < next)
+      next = step;
+  }
+  auto const wait = next - elapsed;
+  return (0 == wait) ? 1 : wait;
+}
+
+Sample sample (uint32_t const norm, uint32_t const length, uint32_t const elapsed, uint8_t const fullScale)
+{
+  MAZE_PROFILE_SCOPE (SitePulse);
+  return {intensity (norm, length, elapsed), wait (norm, length, elapsed, fullScale)};
+}
+
+}}
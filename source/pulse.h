@@ -0,0 +1,39 @@
+#pragma once
+
+#include "profile.h"
+
+#include <cstdint>
+
+namespace maze { namespace pulse {
+
+// Pulse of the rgb led, it fades in the shorter and the brighter the
+// nearer the goal is. Distances are normalized to Q16, 1.0 == 65536,
+// the nRF51 has no fpu.
+uint32_t constexpr sQ16One = 1ul << 16;
+uint32_t constexpr sSlowest = 1200ul /*ms*/;
+uint32_t constexpr sMinResolution = 50ul /*ms*/;
+
+// Walking distance normalized by the largest one, far away if unknown
+uint32_t walkNorm (uint32_t walk, uint32_t maximum);
+
+// Manhattan distance normalized by a range, far away beyond it
+uint32_t rangeNorm (uint32_t manhattan, uint32_t range);
+
+// Length of a pulse in ms, 0 for a constant colour
+uint32_t length (uint32_t norm);
+
+// Intensity in Q16 elapsed ms into a pulse of the given length
+uint32_t intensity (uint32_t norm, uint32_t length, uint32_t elapsed);
+
+// Time in ms from elapsed to the next step of a channel of full scale
+// or to the next pulse start, at least 1
+uint32_t wait (uint32_t norm, uint32_t length, uint32_t elapsed, uint8_t fullScale);
+
+// What one update of the led needs: the intensity and the wait after it
+struct Sample {
+  uint32_t intensity;
+  uint32_t wait;
+};
+Sample sample (uint32_t norm, uint32_t length, uint32_t elapsed, uint8_t fullScale);
+
+}}
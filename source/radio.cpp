@@ -0,0 +1,29 @@
+#include "radio.h"
+
+#include <MicroBit.h>
+
+extern MicroBit uBit;
+
+namespace maze { namespace radio {
+
+bool Transport::start (uint8_t const group)
+{
+  if (MICROBIT_OK != uBit.radio.enable ())
+    return false;
+  uBit.radio.setGroup (group);
+  return true;
+}
+
+void Transport::send (uint8_t const* const data, uint8_t const size)
+{
+  uBit.radio.datagram.send (const_cast<uint8_t*> (data), size);
+}
+
+uint8_t Transport::receive (uint8_t* const data, uint8_t const capacity)
+{
+  // negative if nothing is queued
+  auto const size = uBit.radio.datagram.recv (data, capacity);
+  return (size > 0) ? static_cast<uint8_t> (size) : 0;
+}
+
+}}
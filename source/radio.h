@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ghost.h"
+
+#include <cstdint>
+
+namespace maze { namespace radio {
+
+// Ghost race packets as radio datagrams. The radio cannot run next to
+// bluetooth, it has to be disabled in config.json.
+class Transport : public ghost::Transport
+{
+public:
+  // Turns the radio on, only devices of the same group hear each other
+  bool start (uint8_t group);
+
+  void send (uint8_t const* data, uint8_t size) override;
+  uint8_t receive (uint8_t* data, uint8_t capacity) override;
+};
+
+}}
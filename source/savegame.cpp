@@ -0,0 +1,340 @@
+#include "savegame.h"
+
+#if defined (__arm__)
+#include <MicroBit.h>
+#else
+#include <algorithm>
+#endif
+
+namespace maze { namespace save {
+
+namespace
+{
+
+uint32_t constexpr sMagic = 0x335a534d; // "MSZ3"
+uint32_t constexpr sErased = 0xffffffff;
+
+struct Snapshot {
+  uint32_t magic;
+  uint8_t source;
+  uint8_t level;
+  uint8_t di;
+  uint8_t mode;
+  uint32_t seed;
+  int32_t px;
+  int32_t py;
+  uint8_t doors;
+  uint8_t walls;
+  uint8_t unused [2];
+  // explored words after the snapshot, then the checksum of all words
+  uint32_t explored;
+};
+uint32_t constexpr sSnapshotWords = sizeof (Snapshot) / 4;
+static_assert (sizeof (Snapshot) % 4 == 0, "flash is written in words");
+
+// Records, one word each:
+// byte 0: marker, byte 1: state bits, byte 2: inverted state bits, byte 3: 0
+// move state bits: 0 moved, 1 - 2 move direction, 3 - 4 direction, 5 mode
+// walls state bits: 0 - 3 open doors, 4 - 7 closed timed walls
+uint8_t constexpr sRecordMarker = 0x5a;
+uint8_t constexpr sWallsMarker = 0x3c;
+
+int32_t constexpr sDx [4] = {0, 1, 0, -1};
+int32_t constexpr sDy [4] = {-1, 0, 1, 0};
+
+#if defined (__arm__)
+// One flash page of the nRF51 reserved inside the program image. It
+// starts out zeroed, which is not a valid snapshot, so the first start
+// erases it. Read through volatile, it changes behind the compiler's back.
+uint32_t constexpr sPageSize = 1024;
+alignas (sPageSize) uint32_t const volatile sPage [sPageSize / 4] = {};
+
+class PageFlash : public Flash
+{
+public:
+  uint32_t words () const override
+  {
+    return sPageSize / 4;
+  }
+
+  uint32_t read (uint32_t const word) const override
+  {
+    return sPage [word];
+  }
+
+  void write (uint32_t const word, uint32_t const* data, uint32_t const count) override
+  {
+    mFlash.flash_burn (const_cast<uint32_t*> (&sPage [word]), const_cast<uint32_t*> (data), count);
+  }
+
+  void erase () override
+  {
+    mFlash.erase_page (const_cast<uint32_t*> (&sPage [0]));
+  }
+
+private:
+  MicroBitFlash mFlash;
+};
+#endif
+
+Flash* sFlash = nullptr;
+State sState;
+Explored const* sExplored = nullptr;
+// next free word of the page, none before a start
+uint32_t sNext = ~0u;
+
+Flash& flash ()
+{
+  if (!sFlash)
+  {
+#if defined (__arm__)
+    static PageFlash page;
+#else
+    static FileFlash page ("maze.save");
+#endif
+    sFlash = &page;
+  }
+  return *sFlash;
+}
+
+uint32_t constexpr sChecksumStart = 0x811c9dc5;
+
+// FNV-1a over words
+uint32_t checksum (uint32_t sum, uint32_t const* words, uint32_t const count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    sum = (sum ^ words [i]) * 0x01000193;
+  return sum;
+}
+
+uint32_t encode (uint8_t const marker, uint8_t const bits)
+{
+  return marker | (bits << 8) | ((~bits & 0xff) << 16);
+}
+
+void apply (State& state, uint8_t const bits)
+{
+  if (bits & 1)
+  {
+    auto const moveDi = (bits >> 1) & 3;
+    state.px += sDx [moveDi];
+    state.py += sDy [moveDi];
+  }
+  state.di = (bits >> 3) & 3;
+  state.mode = (bits >> 5) & 1;
+}
+
+void applyWalls (State& state, uint8_t const bits)
+{
+  state.doors = bits & 15;
+  state.walls = bits >> 4;
+}
+
+// Writes a record, a full page is compacted into a snapshot that
+// already holds it
+void append (uint32_t const word)
+{
+  auto& page = flash ();
+  if (sNext >= page.words ())
+  {
+    start (sState, sExplored);
+    return;
+  }
+
+  page.write (sNext, &word, 1);
+  ++sNext;
+}
+
+}
+
+#if !defined (__arm__)
+FileFlash::FileFlash (char const* const path, uint32_t const words)
+  : mWords (words, sErased)
+{
+  // an existing page is kept, a new or short one is erased
+  mFile = std::fopen (path, "r+b");
+  if (mFile)
+  {
+    auto const read = std::fread (mWords.data (), 4, words, mFile);
+    std::fill (mWords.begin () + read, mWords.end (), sErased);
+  }
+  else
+    mFile = std::fopen (path, "w+b");
+  if (mFile)
+    store (0, words);
+}
+
+FileFlash::~FileFlash ()
+{
+  if (mFile)
+    std::fclose (mFile);
+}
+
+uint32_t FileFlash::words () const
+{
+  return static_cast<uint32_t> (mWords.size ());
+}
+
+uint32_t FileFlash::read (uint32_t const word) const
+{
+  return mWords [word];
+}
+
+void FileFlash::write (uint32_t const word, uint32_t const* data, uint32_t const count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (sErased != mWords [word + i])
+      ++mStats.rewrites;
+    // programming clears bits, it never sets them
+    mWords [word + i] &= data [i];
+  }
+  mStats.writes += count;
+  store (word, count);
+}
+
+void FileFlash::erase ()
+{
+  std::fill (mWords.begin (), mWords.end (), sErased);
+  ++mStats.erases;
+  store (0, words ());
+}
+
+FileFlash::Stats const& FileFlash::stats () const
+{
+  return mStats;
+}
+
+void FileFlash::store (uint32_t const word, uint32_t const count)
+{
+  if (!mFile)
+    return;
+  std::fseek (mFile, static_cast<long> (word) * 4, SEEK_SET);
+  std::fwrite (&mWords [word], 4, count, mFile);
+  std::fflush (mFile);
+}
+#endif
+
+void use (Flash& page)
+{
+  sFlash = &page;
+  sNext = ~0u;
+}
+
+bool load (State& state, Explored* const explored, void (*replayed) (State const&))
+{
+  auto const& page = flash ();
+  Snapshot snapshot;
+  auto* words = reinterpret_cast<uint32_t*> (&snapshot);
+  for (uint32_t i = 0; i < sSnapshotWords; ++i)
+    words [i] = page.read (i);
+  if (sMagic != snapshot.magic || snapshot.explored > sMaxExploredWords)
+    return false;
+
+  auto sum = checksum (sChecksumStart, words, sSnapshotWords);
+  auto const end = sSnapshotWords + snapshot.explored;
+  for (auto word = sSnapshotWords; word < end; ++word)
+  {
+    auto const bits = page.read (word);
+    sum = checksum (sum, &bits, 1);
+  }
+  if (page.read (end) != sum)
+    return false;
+
+  state.source = snapshot.source;
+  state.level = snapshot.level;
+  state.seed = snapshot.seed;
+  state.px = snapshot.px;
+  state.py = snapshot.py;
+  state.di = snapshot.di;
+  state.mode = snapshot.mode;
+  state.doors = snapshot.doors;
+  state.walls = snapshot.walls;
+
+  if (explored && explored->words () == snapshot.explored)
+    for (uint32_t i = 0; i < snapshot.explored; ++i)
+      explored->data () [i] = page.read (sSnapshotWords + i);
+  // the move that compacted was seen after its snapshot
+  if (replayed)
+    replayed (state);
+
+  for (auto word = end + 1; word < page.words (); ++word)
+  {
+    auto const record = page.read (word);
+    if (sErased == record)
+      break;
+
+    // a torn or damaged record and all after it are dropped
+    auto const bits = static_cast<uint8_t> (record >> 8);
+    if (encode (sWallsMarker, bits) == record)
+    {
+      applyWalls (state, bits);
+      continue;
+    }
+    if (encode (sRecordMarker, bits) != record)
+      break;
+    apply (state, bits);
+    if (replayed)
+      replayed (state);
+  }
+  return true;
+}
+
+void start (State const& state, Explored const* const explored)
+{
+  sState = state;
+  sExplored = explored;
+
+  Snapshot snapshot;
+  snapshot.magic = sMagic;
+  snapshot.source = state.source;
+  snapshot.level = state.level;
+  snapshot.di = state.di;
+  snapshot.mode = state.mode;
+  snapshot.seed = state.seed;
+  snapshot.px = state.px;
+  snapshot.py = state.py;
+  snapshot.doors = state.doors;
+  snapshot.walls = state.walls;
+  snapshot.unused [0] = 0;
+  snapshot.unused [1] = 0;
+  // too many to keep, the level resumes unexplored
+  snapshot.explored = 0;
+  if (explored && explored->words () <= sMaxExploredWords)
+    snapshot.explored = static_cast<uint32_t> (explored->words ());
+
+  auto const* words = reinterpret_cast<uint32_t const*> (&snapshot);
+  auto sum = checksum (sChecksumStart, words, sSnapshotWords);
+  auto& page = flash ();
+  page.erase ();
+  page.write (0, words, sSnapshotWords);
+  if (snapshot.explored > 0)
+  {
+    sum = checksum (sum, explored->data (), snapshot.explored);
+    page.write (sSnapshotWords, explored->data (), snapshot.explored);
+  }
+  page.write (sSnapshotWords + snapshot.explored, &sum, 1);
+  sNext = sSnapshotWords + snapshot.explored + 1;
+}
+
+void record (bool const moved, uint8_t const moveDi, uint8_t const di, uint8_t const mode)
+{
+  uint8_t const bits = (moved ? 1 : 0) | ((moveDi & 3) << 1) | ((di & 3) << 3) | ((mode & 1) << 5);
+  apply (sState, bits);
+  append (encode (sRecordMarker, bits));
+}
+
+void recordWalls (uint8_t const doors, uint8_t const walls)
+{
+  uint8_t const bits = (doors & 15) | ((walls & 15) << 4);
+  applyWalls (sState, bits);
+  append (encode (sWallsMarker, bits));
+}
+
+void clear ()
+{
+  flash ().erase ();
+  sNext = ~0u;
+}
+
+}}
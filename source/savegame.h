@@ -0,0 +1,111 @@
+#pragma once
+
+#include "explored.h"
+
+#include <cstdint>
+#if !defined (__arm__)
+#include <cstdio>
+#include <vector>
+#endif
+
+namespace maze { namespace save {
+
+// Everything needed to continue a game after a power loss
+struct State {
+  // level identity
+  uint8_t source = 0;
+  uint8_t level = 0;
+  uint32_t seed = 0;
+  // player
+  int32_t px = 0;
+  int32_t py = 0;
+  uint8_t di = 0;
+  uint8_t mode = 0;
+  // changing walls: a bit per open door and closed timed wall
+  uint8_t doors = 0;
+  uint8_t walls = 0;
+};
+
+// Doors and timed walls a save keeps
+uint8_t constexpr sMaxDoors = 4;
+uint8_t constexpr sMaxTimedWalls = 4;
+
+// Explored words a snapshot keeps, half the page. Larger levels resume
+// with nothing seen.
+uint32_t constexpr sMaxExploredWords = 128;
+
+// The flash page the save log lives in. Erased words read all ones, a
+// write can only clear bits of a word.
+class Flash
+{
+public:
+  virtual ~Flash () = default;
+
+  // size of the page in 32 bit words
+  virtual uint32_t words () const = 0;
+  virtual uint32_t read (uint32_t word) const = 0;
+  virtual void write (uint32_t word, uint32_t const* data, uint32_t count) = 0;
+  virtual void erase () = 0;
+};
+
+#if !defined (__arm__)
+// A page kept in a file on the build host, erased if the file is new.
+// Every write and erase goes to the file at once, so a process killed in
+// between leaves the page as a power loss would.
+class FileFlash : public Flash
+{
+public:
+  struct Stats {
+    uint32_t erases = 0;
+    uint64_t writes = 0;
+    // words written without an erase since their last write
+    uint64_t rewrites = 0;
+  };
+
+  explicit FileFlash (char const* path, uint32_t words = 256);
+  ~FileFlash () override;
+
+  uint32_t words () const override;
+  uint32_t read (uint32_t word) const override;
+  void write (uint32_t word, uint32_t const* data, uint32_t count) override;
+  void erase () override;
+
+  Stats const& stats () const;
+
+private:
+  void store (uint32_t word, uint32_t count);
+
+  std::FILE* mFile = nullptr;
+  std::vector<uint32_t> mWords;
+  Stats mStats;
+};
+#endif
+
+// Saves go to this flash from now on. The default is a page reserved in
+// the program image on the device and the file maze.save on the build
+// host. Needs a start before the next record.
+void use (Flash& flash);
+
+// Restores the last state: the snapshot at the start of the save page
+// plus all move records appended after it. False if there is none.
+// Explored of the saved size gets the cells seen up to the snapshot,
+// replayed is called with the snapshot state and the one after each
+// move record.
+bool load (State& state, Explored* explored = nullptr, void (*replayed) (State const&) = nullptr);
+
+// Erases the save page and writes a snapshot of the state and the cells
+// explored, which are saved again on every compaction
+void start (State const& state, Explored const* explored = nullptr);
+
+// Appends one move record: a step into moveDi if moved, the direction
+// and view mode afterwards. Compacts into a new snapshot when the page
+// is full.
+void record (bool moved, uint8_t moveDi, uint8_t di, uint8_t mode);
+
+// Appends the open doors and closed timed walls, compacts like a move
+void recordWalls (uint8_t doors, uint8_t walls);
+
+// Forgets the saved game
+void clear ();
+
+}}
@@ -0,0 +1,103 @@
+#include "sound.h"
+
+extern MicroBit uBit;
+
+namespace maze { namespace sound {
+
+namespace
+{
+
+uint16_t constexpr sSoundEventId = 9501;
+uint16_t constexpr sEvtQueued = 1;
+uint16_t constexpr sEvtIdle = 2;
+
+struct Command {
+  uint16_t hertz;
+  uint16_t period;
+  uint16_t pause;
+};
+
+// Ring buffer, the capacity must be a power of two.
+// Head and tail only grow and wrap, their difference is the fill level.
+uint8_t constexpr sCapacity = 32;
+Command sQueue [sCapacity];
+uint8_t sHead = 0;
+uint8_t sTail = 0;
+
+bool sPlaying = false;
+bool sStarted = false;
+
+uint8_t size ()
+{
+  return static_cast<uint8_t> (sTail - sHead);
+}
+
+void loop ()
+{
+  for (;;)
+  {
+    if (0 == size ())
+    {
+      sPlaying = false;
+      MicroBitEvent (sSoundEventId, sEvtIdle);
+      fiber_wait_for_event (sSoundEventId, sEvtQueued);
+      continue;
+    }
+
+    sPlaying = true;
+    auto const command = sQueue [sHead & (sCapacity - 1)];
+    ++sHead;
+
+    if (melody::br != command.hertz)
+      uBit.soundmotor.soundOn (command.hertz);
+    else
+      uBit.soundmotor.soundOff ();
+    uBit.sleep (command.period);
+
+    uBit.soundmotor.soundOff ();
+    if (command.pause > 0)
+      uBit.sleep (command.pause);
+  }
+}
+
+}
+
+void start ()
+{
+  if (sStarted)
+    return;
+
+  sStarted = true;
+  create_fiber (loop);
+}
+
+bool play (melody::Tone const* tones, size_t const count, uint16_t const pause)
+{
+  if (count > static_cast<size_t> (sCapacity - size ()))
+    return false;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto& command = sQueue [sTail & (sCapacity - 1)];
+    command.hertz = tones [i].hertz;
+    command.period = tones [i].period;
+    command.pause = pause;
+    ++sTail;
+  }
+
+  MicroBitEvent (sSoundEventId, sEvtQueued);
+  return true;
+}
+
+bool idle ()
+{
+  return 0 == size () && !sPlaying;
+}
+
+void wait ()
+{
+  while (!idle ())
+    fiber_wait_for_event (sSoundEventId, sEvtIdle);
+}
+
+}}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "melody.h"
+
+#include <cstddef>
+
+namespace maze { namespace sound {
+
+// Starts the fiber playing the queued tones
+void start ();
+
+// Queues the tones, each followed by a pause of silence, and returns
+// immediately. Queues nothing and returns false if they do not fit.
+bool play (melody::Tone const* tones, size_t count, uint16_t pause = 0);
+
+template <size_t N>
+bool play (melody::Tone const (&tones) [N], uint16_t const pause = 0)
+{
+  return play (tones, N, pause);
+}
+
+// Nothing queued or playing
+bool idle ();
+
+// Blocks the calling fiber until all queued tones are played
+void wait ();
+
+}}
@@ -0,0 +1,285 @@
+#include "tiles.h"
+
+namespace maze
+{
+
+namespace
+{
+
+uint16_t constexpr sAllSet = 0xffff;
+
+uint32_t hash (uint32_t const seed, int32_t const tx, int32_t const ty)
+{
+  auto h = seed ^ (static_cast<uint32_t> (tx) * 0x9e3779b1u) ^ (static_cast<uint32_t> (ty) * 0x85ebca77u);
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+  return h ? h : 1u;
+}
+
+uint32_t nextRandom (uint32_t& state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+void fill (TileRows& rows, Layer const layer, uint16_t const value)
+{
+  for (auto& row : rows [layer])
+    row = value;
+}
+
+void set (TileRows& rows, Layer const layer, int32_t const x, int32_t const y, bool const value)
+{
+  auto const mask = static_cast<uint16_t> (1u << x);
+  rows [layer][y] = value ? (rows [layer][y] | mask) : (rows [layer][y] & ~mask);
+}
+
+bool test (TileRows const& rows, Layer const layer, int32_t const x, int32_t const y)
+{
+  return (rows [layer][y] >> x) & 1u;
+}
+
+void setTile (TileRows& rows, int32_t const x, int32_t const y, uint8_t const tile)
+{
+  set (rows, LayerBlocking, x, y, 8 < tile);
+  set (rows, LayerVisible, x, y, 4 < tile);
+  set (rows, LayerTrap, x, y, 1 == tile);
+  set (rows, LayerDark, x, y, 2 == tile);
+  set (rows, LayerTwister, x, y, 3 == tile);
+}
+
+void solid (TileRows& rows)
+{
+  for (int layer = 0; layer < LayerCount; ++layer)
+    fill (rows, static_cast<Layer> (layer), (layer <= LayerVisible) ? sAllSet : 0);
+}
+
+}
+
+PackTiles::PackTiles (LevelPack const& pack, uint8_t const level)
+  : mPack (pack)
+  , mLevel (level)
+  , mInfo (pack.info (level))
+{
+}
+
+void PackTiles::decode (int32_t const tx, int32_t const ty, TileRows& rows) const
+{
+  solid (rows);
+
+  uint8_t tiles [sTileSize];
+  for (int32_t ly = 0; ly < sTileSize; ++ly)
+  {
+    auto const y = (ty << sTileShift) + ly;
+    if (y >= mInfo.height)
+      break;
+
+    mPack.span (mLevel, y, tx << sTileShift, sTileSize, tiles);
+    for (int32_t lx = 0; lx < sTileSize; ++lx)
+      setTile (rows, lx, ly, tiles [lx]);
+  }
+}
+
+GeneratedTiles::GeneratedTiles (uint32_t const seed, int32_t const tilesX, int32_t const tilesY)
+  : mSeed (seed)
+  , mTilesX (tilesX)
+  , mTilesY (tilesY)
+{
+}
+
+void GeneratedTiles::decode (int32_t const tx, int32_t const ty, TileRows& rows) const
+{
+  solid (rows);
+  if (tx >= mTilesX || ty >= mTilesY)
+    return;
+
+  // 8 x 8 cells at the odd positions, carved by a backtracker with the
+  // way back stored per cell
+  int32_t constexpr cells = sTileSize / 2;
+  int32_t const dx [4] = {0, 1, 0, -1};
+  int32_t const dy [4] = {-1, 0, 1, 0};
+  uint8_t back [cells * cells] = {};
+  auto state = hash (mSeed, tx, ty);
+
+  auto carve = [&rows] (int32_t const x, int32_t const y) {
+    set (rows, LayerBlocking, x, y, false);
+    set (rows, LayerVisible, x, y, false);
+  };
+
+  int32_t cx = 0;
+  int32_t cy = 0;
+  carve (1, 1);
+  for (;;)
+  {
+    int candidates [4];
+    int count = 0;
+    for (int di = 0; di < 4; ++di)
+    {
+      auto const nx = cx + dx [di];
+      auto const ny = cy + dy [di];
+      if (nx >= 0 && ny >= 0 && nx < cells && ny < cells &&
+          test (rows, LayerBlocking, 2 * nx + 1, 2 * ny + 1))
+        candidates [count++] = di;
+    }
+
+    if (count > 0)
+    {
+      auto const di = candidates [nextRandom (state) % count];
+      carve (2 * cx + 1 + dx [di], 2 * cy + 1 + dy [di]);
+      cx += dx [di];
+      cy += dy [di];
+      carve (2 * cx + 1, 2 * cy + 1);
+      back [cy * cells + cx] = (di + 2) & 3;
+      continue;
+    }
+
+    if (0 == cx && 0 == cy)
+      break;
+
+    auto const di = back [cy * cells + cx];
+    cx += dx [di];
+    cy += dy [di];
+  }
+
+  // doors into the tiles west and north, their east and south walls are ours
+  auto const doors = hash (mSeed ^ 0x5bd1e995u, tx, ty);
+  if (tx > 0)
+    carve (0, 2 * (doors % cells) + 1);
+  if (ty > 0)
+    carve (2 * ((doors >> 8) % cells) + 1, 0);
+
+  // special tiles, never at the start or the goal
+  for (int32_t ly = 1; ly < sTileSize; ly += 2)
+    for (int32_t lx = 1; lx < sTileSize; lx += 2)
+    {
+      auto const x = (tx << sTileShift) + lx;
+      auto const y = (ty << sTileShift) + ly;
+      if ((1 == x && 1 == y) || (width () - 2 == x && height () - 2 == y))
+        continue;
+
+      // the cells east and south of the tile are in the next tiles and
+      // not known, they count as walls
+      auto const roll = nextRandom (state) % 1000;
+      auto open = 0;
+      for (int di = 0; di < 4; ++di)
+      {
+        auto const nx = lx + dx [di];
+        auto const ny = ly + dy [di];
+        if (nx < sTileSize && ny < sTileSize && !test (rows, LayerBlocking, nx, ny))
+          ++open;
+      }
+
+      // no traps at the border, the unknown neighbour may be open
+      if (1 == open && lx < sTileSize - 1 && ly < sTileSize - 1 && roll < 200)
+        setTile (rows, lx, ly, 1);
+      else if (open > 1 && roll < 30)
+        setTile (rows, lx, ly, 3);
+      else if (roll >= 940)
+        setTile (rows, lx, ly, 2);
+    }
+}
+
+void TileCache::reset (TileSource const* source)
+{
+  mSource = source;
+  for (auto& tile : mTiles)
+  {
+    tile.tx = -1;
+    tile.ty = -1;
+    tile.used = 0;
+  }
+  mLast = 0;
+  mClock = 0;
+  mStats = Stats ();
+}
+
+uint8_t TileCache::tile (int32_t const x, int32_t const y) const
+{
+  if (test (LayerBlocking, x, y))
+    return 9;
+  if (test (LayerVisible, x, y))
+    return 8;
+  if (test (LayerTrap, x, y))
+    return 1;
+  if (test (LayerDark, x, y))
+    return 2;
+  if (test (LayerTwister, x, y))
+    return 3;
+  return 0;
+}
+
+TileCache::Tile const& TileCache::fetch (int32_t const tx, int32_t const ty) const
+{
+  // most lookups hit the tile of the last one
+  auto& last = mTiles [mLast];
+  if (last.tx == tx && last.ty == ty)
+  {
+    ++mStats.hits;
+    return last;
+  }
+
+  uint8_t oldest = 0;
+  for (uint8_t i = 0; i < sCapacity; ++i)
+  {
+    auto& tile = mTiles [i];
+    if (tile.tx == tx && tile.ty == ty)
+    {
+      ++mStats.hits;
+      tile.used = ++mClock;
+      mLast = i;
+      return tile;
+    }
+    if (tile.used < mTiles [oldest].used)
+      oldest = i;
+  }
+
+  ++mStats.misses;
+  auto& tile = mTiles [oldest];
+  if (tile.tx >= 0)
+    ++mStats.evictions;
+  tile.tx = tx;
+  tile.ty = ty;
+  tile.used = ++mClock;
+  mSource->decode (tx, ty, tile.rows);
+  mLast = oldest;
+  return tile;
+}
+
+void TileCache::prefetch (int32_t const x, int32_t const y)
+{
+  auto const lx = x & (sTileSize - 1);
+  auto const ly = y & (sTileSize - 1);
+  auto const tx = x >> sTileShift;
+  auto const ty = y >> sTileShift;
+
+  auto const west = lx < sPrefetchDistance;
+  auto const east = lx >= sTileSize - sPrefetchDistance;
+  auto const north = ly < sPrefetchDistance;
+  auto const south = ly >= sTileSize - sPrefetchDistance;
+
+  auto const load = [this] (int32_t const px, int32_t const py) {
+    if (px >= 0 && py >= 0 && (px << sTileShift) < width () && (py << sTileShift) < height ())
+      fetch (px, py);
+  };
+
+  if (west)
+    load (tx - 1, ty);
+  if (east)
+    load (tx + 1, ty);
+  if (north)
+    load (tx, ty - 1);
+  if (south)
+    load (tx, ty + 1);
+  if ((west || east) && (north || south))
+    load (tx + (west ? -1 : 1), ty + (north ? -1 : 1));
+
+  // keep the tile of the player the most recent one
+  fetch (tx, ty);
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "bitmaze.h"
+#include "levelpack.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+// Worlds too large for RAM are split into tiles of 16 x 16 cells,
+// one 16 bit row mask per layer and tile row
+int32_t constexpr sTileShift = 4;
+int32_t constexpr sTileSize = 1 << sTileShift;
+
+using TileRows = uint16_t [LayerCount][sTileSize];
+
+// Produces the tiles of a world on demand
+class TileSource
+{
+public:
+  virtual ~TileSource () = default;
+
+  virtual int32_t width () const = 0;
+  virtual int32_t height () const = 0;
+
+  // Fills the rows of tile (tx, ty), cells outside the world are blocking walls
+  virtual void decode (int32_t tx, int32_t ty, TileRows& rows) const = 0;
+};
+
+// Tiles of a level pack level, only the needed part of each row is decoded
+class PackTiles : public TileSource
+{
+public:
+  PackTiles (LevelPack const& pack, uint8_t level);
+
+  int32_t width () const override { return mInfo.width; }
+  int32_t height () const override { return mInfo.height; }
+  LevelInfo const& info () const { return mInfo; }
+
+  void decode (int32_t tx, int32_t ty, TileRows& rows) const override;
+
+private:
+  LevelPack mPack;
+  uint8_t mLevel;
+  LevelInfo mInfo;
+};
+
+// Endless generated world: every tile is a small perfect maze from a hash
+// of the seed and its position, with one door to the tile west and north
+// of it. The start is the upper left, the goal the lower right cell.
+class GeneratedTiles : public TileSource
+{
+public:
+  GeneratedTiles (uint32_t seed, int32_t tilesX, int32_t tilesY);
+
+  int32_t width () const override { return mTilesX * sTileSize + 1; }
+  int32_t height () const override { return mTilesY * sTileSize + 1; }
+
+  void decode (int32_t tx, int32_t ty, TileRows& rows) const override;
+
+private:
+  uint32_t mSeed;
+  int32_t mTilesX;
+  int32_t mTilesY;
+};
+
+// Small LRU cache of decoded tiles with the read interface of BitMaze.
+// RAM use is fixed by the capacity, whatever the size of the world.
+class TileCache
+{
+public:
+  static uint8_t constexpr sCapacity = 6;
+  // Distance to a tile border that triggers loading the next tile,
+  // the depth view looks this far ahead
+  static int32_t constexpr sPrefetchDistance = 3;
+
+  struct Stats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t evictions = 0;
+  };
+
+  // Drops all tiles
+  void reset (TileSource const* source);
+
+  int32_t width () const { return mSource ? mSource->width () : 0; }
+  int32_t height () const { return mSource ? mSource->height () : 0; }
+  size_t bytes () const { return sizeof (mTiles); }
+
+  bool test (Layer const layer, int32_t const x, int32_t const y) const
+  {
+    if (x < 0 || y < 0 || x >= width () || y >= height ())
+      return LayerBlocking == layer || LayerVisible == layer;
+
+    auto const& tile = fetch (x >> sTileShift, y >> sTileShift);
+    return (tile.rows [layer][y & (sTileSize - 1)] >> (x & (sTileSize - 1))) & 1u;
+  }
+
+  uint8_t tile (int32_t x, int32_t y) const;
+
+  // Loads the tiles next to the position if it is close to a border,
+  // so the next steps hit the cache
+  void prefetch (int32_t x, int32_t y);
+
+  Stats const& stats () const { return mStats; }
+
+private:
+  struct Tile {
+    int32_t tx = -1;
+    int32_t ty = -1;
+    uint32_t used = 0;
+    TileRows rows;
+  };
+
+  Tile const& fetch (int32_t tx, int32_t ty) const;
+
+  TileSource const* mSource = nullptr;
+  mutable Tile mTiles [sCapacity];
+  mutable uint8_t mLast = 0;
+  mutable uint32_t mClock = 0;
+  mutable Stats mStats;
+};
+
+}
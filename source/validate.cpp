@@ -0,0 +1,156 @@
+#include "validate.h"
+
+#include <vector>
+
+namespace maze
+{
+
+namespace
+{
+
+uint32_t walkable (BitMaze const& maze, int32_t const y, int32_t const w)
+{
+  auto const used = (w == maze.stride () - 1 && (maze.width () & 31))
+    ? (1u << (maze.width () & 31)) - 1
+    : ~0u;
+  return ~maze.row (LayerBlocking, y) [w] & ~maze.row (LayerTrap, y) [w] & used;
+}
+
+// Spreads the reached cells along row y, returns true if it changed
+bool fillRow (BitMaze const& maze, std::vector<uint32_t>& reached, int32_t const y)
+{
+  auto const stride = maze.stride ();
+  auto* row = &reached [y * stride];
+  bool changed = false;
+  bool again = true;
+  while (again)
+  {
+    again = false;
+    for (int32_t w = 0; w < stride; ++w)
+    {
+      auto const open = walkable (maze, y, w);
+      auto grown = row [w];
+      grown |= (grown << 1) | (grown >> 1);
+      if (w > 0)
+        grown |= row [w - 1] >> 31;
+      if (w < stride - 1)
+        grown |= row [w + 1] << 31;
+      grown &= open;
+      if (grown != row [w])
+      {
+        row [w] = grown;
+        again = true;
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+// Takes over reached cells of row from into row y
+bool fillFrom (BitMaze const& maze, std::vector<uint32_t>& reached, int32_t const y, int32_t const from)
+{
+  auto const stride = maze.stride ();
+  bool changed = false;
+  for (int32_t w = 0; w < stride; ++w)
+  {
+    auto const grown = (reached [y * stride + w] | reached [from * stride + w]) & walkable (maze, y, w);
+    if (grown != reached [y * stride + w])
+    {
+      reached [y * stride + w] = grown;
+      changed = true;
+    }
+  }
+  return fillRow (maze, reached, y) || changed;
+}
+
+bool closedBorder (BitMaze const& maze)
+{
+  auto const w = maze.width ();
+  auto const h = maze.height ();
+  for (int32_t x = 0; x < w; ++x)
+    if (!maze.test (LayerBlocking, x, 0) || !maze.test (LayerBlocking, x, h - 1))
+      return false;
+  for (int32_t y = 0; y < h; ++y)
+    if (!maze.test (LayerBlocking, 0, y) || !maze.test (LayerBlocking, w - 1, y))
+      return false;
+  return true;
+}
+
+bool isWalkable (BitMaze const& maze, int32_t const x, int32_t const y)
+{
+  return x >= 0 && y >= 0 && x < maze.width () && y < maze.height () &&
+         !maze.test (LayerBlocking, x, y);
+}
+
+}
+
+Report validate (BitMaze const& maze, int32_t const sx, int32_t const sy, int32_t const ex, int32_t const ey)
+{
+  Report report;
+  auto const width = maze.width ();
+  auto const height = maze.height ();
+  if (width < 3 || height < 3)
+    return report;
+
+  report.closedBorder = closedBorder (maze);
+
+  // flood fill from the start
+  std::vector<uint32_t> reached (static_cast<size_t> (height) * maze.stride (), 0u);
+  if (isWalkable (maze, sx, sy) && !maze.test (LayerTrap, sx, sy))
+  {
+    reached [sy * maze.stride () + (sx >> 5)] = 1u << (sx & 31);
+    fillRow (maze, reached, sy);
+
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (int32_t y = 1; y < height; ++y)
+        changed = fillFrom (maze, reached, y, y - 1) || changed;
+      for (int32_t y = height - 2; y >= 0; --y)
+        changed = fillFrom (maze, reached, y, y + 1) || changed;
+    }
+  }
+
+  for (auto const word : reached)
+    for (auto bits = word; bits; bits &= bits - 1)
+      ++report.reachableCells;
+  report.reachable = isWalkable (maze, ex, ey) &&
+    ((reached [ey * maze.stride () + (ex >> 5)] >> (ex & 31)) & 1u);
+
+  int32_t const dx [4] = {0, 1, 0, -1};
+  int32_t const dy [4] = {-1, 0, 1, 0};
+  for (int32_t y = 0; y < height; ++y)
+    for (int32_t x = 0; x < width; ++x)
+    {
+      if (maze.test (LayerTwister, x, y) && isWalkable (maze, x, y))
+      {
+        bool exit = false;
+        for (int di = 0; di < 4 && !exit; ++di)
+        {
+          auto const nx = x + dx [di];
+          auto const ny = y + dy [di];
+          exit = isWalkable (maze, nx, ny) &&
+                 !maze.test (LayerTwister, nx, ny) &&
+                 !maze.test (LayerTrap, nx, ny);
+        }
+        if (!exit)
+          ++report.twisterLoops;
+      }
+
+      if (maze.test (LayerVisible, x, y) && !maze.test (LayerBlocking, x, y))
+      {
+        ++report.secretWalls;
+        if ((isWalkable (maze, x - 1, y) && isWalkable (maze, x + 1, y) &&
+             !maze.test (LayerVisible, x - 1, y) && !maze.test (LayerVisible, x + 1, y)) ||
+            (isWalkable (maze, x, y - 1) && isWalkable (maze, x, y + 1) &&
+             !maze.test (LayerVisible, x, y - 1) && !maze.test (LayerVisible, x, y + 1)))
+          ++report.shortcuts;
+      }
+    }
+
+  return report;
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "bitmaze.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+struct Report {
+  // the outer rows and columns are blocking walls
+  bool closedBorder = false;
+  // the goal can be reached from the start without stepping on a trap
+  bool reachable = false;
+  // cells reachable from the start without traps
+  uint32_t reachableCells = 0;
+  // twisters that can only be left onto another twister or a trap
+  uint32_t twisterLoops = 0;
+  uint32_t secretWalls = 0;
+  // secret walls between two walkable cells on opposite sides
+  uint32_t shortcuts = 0;
+
+  bool valid () const { return closedBorder && reachable && 0 == twisterLoops; }
+};
+
+// Checks a level. Reachability is a flood fill over the rows as bit sets:
+// sweeps down and up the rows, spreading along each row word by word,
+// until nothing changes.
+Report validate (BitMaze const& maze, int32_t sx, int32_t sy, int32_t ex, int32_t ey);
+
+}
@@ -0,0 +1,105 @@
+#include "view.h"
+
+#include <cstring>
+
+namespace maze
+{
+
+namespace
+{
+
+// Pixel (x, y) of the rendered view:
+// the outer columns are the walls left and right of the player, the
+// corners of the outer frame are always visible. A wall in front fills
+// the middle frame, else the middle frame is the next cell with its side
+// walls in the middle of columns 1 and 3, and the center shades the wall
+// two or three cells ahead.
+constexpr uint8_t viewPixel (uint8_t const view, int const x, int const y)
+{
+  return (0 == x) ? ((0 == y || 4 == y || (view & 1)) ? sShade [0] : 0)
+       : (4 == x) ? ((0 == y || 4 == y || (view & 4)) ? sShade [0] : 0)
+       : (0 == y || 4 == y) ? 0
+       : (view & 2) ? sShade [0]
+       : (1 == x && 2 == y) ? ((view & 8) ? sShade [1] : 0)
+       : (3 == x && 2 == y) ? ((view & 32) ? sShade [1] : 0)
+       : (2 == x && 2 == y) ? ((view & 16) ? sShade [1] : (view & 64) ? sShade [2] : 0)
+       : sShade [1];
+}
+
+// Front walls in the way to a ghost at depth 0 to 3 of the view
+uint8_t constexpr sGhostFronts [4] = {0, 2, 2 | 16, 2 | 16 | 64};
+
+}
+
+#define VIEW_ROW(v, y) \
+  viewPixel (v, 0, y), viewPixel (v, 1, y), viewPixel (v, 2, y), \
+  viewPixel (v, 3, y), viewPixel (v, 4, y)
+#define VIEW(v) \
+  { VIEW_ROW (v, 0), VIEW_ROW (v, 1), VIEW_ROW (v, 2), VIEW_ROW (v, 3), VIEW_ROW (v, 4) }
+#define VIEWS2(v) VIEW (v), VIEW (v + 1)
+#define VIEWS8(v) VIEWS2 (v), VIEWS2 (v + 2), VIEWS2 (v + 4), VIEWS2 (v + 6)
+#define VIEWS32(v) VIEWS8 (v), VIEWS8 (v + 8), VIEWS8 (v + 16), VIEWS8 (v + 24)
+
+uint8_t const sViews [1 << sConeSize][25] = {
+  VIEWS32 (0), VIEWS32 (32), VIEWS32 (64), VIEWS32 (96)
+};
+
+#undef VIEWS32
+#undef VIEWS8
+#undef VIEWS2
+#undef VIEW
+#undef VIEW_ROW
+
+void explore (Explored& explored, uint8_t const view, int32_t const px, int32_t const py, uint8_t const di)
+{
+  uint8_t seen = 1 | 2 | 4;
+  if (0 == (view & 2))
+    seen |= 8 | 16 | 32;
+  if (0 == (view & (2 | 16)))
+    seen |= 64;
+
+  auto const& cone = sCone [di & 3];
+  explored.mark (px, py);
+  for (int i = 0; i < sConeSize; ++i)
+    if (seen & (1 << i))
+      explored.mark (px + cone [i].x, py + cone [i].y);
+}
+
+void drawView (uint8_t* const pixels, uint8_t const view, int32_t const px, int32_t const py,
+               uint8_t const di, ghost::Race const& race)
+{
+  memcpy (pixels, sViews [view], sizeof (sViews [0]));
+
+  auto const& look = sLook [di & 3];
+  for (uint8_t i = 0; i < ghost::sMaxGhosts; ++i)
+  {
+    auto const& ghost = race.ghosts () [i];
+    if (!ghost.active)
+      continue;
+
+    auto const dx = ghost.position.px - px;
+    auto const dy = ghost.position.py - py;
+    auto const depth = dx * look [0].x + dy * look [0].y;
+    auto const side = dx * look [2].x + dy * look [2].y;
+    if (0 != side || depth < 0 || depth > 3 || 0 != (view & sGhostFronts [depth]))
+      continue;
+
+    auto const shade = sShade [(depth > 0) ? depth - 1 : 0];
+    if (pixels [4 * 5 + 2] < shade)
+      pixels [4 * 5 + 2] = shade;
+  }
+}
+
+void drawMapGhosts (uint8_t* const pixels, int32_t const px, int32_t const py, ghost::Race const& race)
+{
+  for (uint8_t i = 0; i < ghost::sMaxGhosts; ++i)
+  {
+    auto const& ghost = race.ghosts () [i];
+    auto const x = ghost.position.px - px + 2;
+    auto const y = ghost.position.py - py + 2;
+    if (ghost.active && x >= 0 && y >= 0 && x < 5 && y < 5 && 0 == pixels [y * 5 + x])
+      pixels [y * 5 + x] = sGhostShade;
+  }
+}
+
+}
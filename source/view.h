@@ -0,0 +1,146 @@
+#pragma once
+
+#include "bitmaze.h"
+#include "explored.h"
+#include "ghost.h"
+#include "profile.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+// Rendering of the depth view and the map into 5x5 greyscale pixels,
+// free of the device so the host tools can run it
+
+// Relative cell offsets of front, left and right per direction
+struct Offset {
+  int8_t x;
+  int8_t y;
+};
+Offset constexpr sLook [4][3] = {
+  // front     left       right
+  {{ 0, -1}, {-1,  0}, { 1,  0}}, // North
+  {{ 1,  0}, { 0, -1}, { 0,  1}}, // East
+  {{ 0,  1}, { 1,  0}, {-1,  0}}, // South
+  {{-1,  0}, { 0,  1}, { 0, -1}}  // West
+};
+
+// Cells of the depth view as depth ahead and side (-1 left, 1 right),
+// bit i of a view is a visible wall on cell i
+struct ConeCell {
+  int8_t depth;
+  int8_t side;
+};
+int constexpr sConeSize = 7;
+ConeCell constexpr sConeCells [sConeSize] = {
+  {0, -1}, {1, 0}, {0, 1}, // left, front, right
+  {1, -1}, {2, 0}, {1, 1}, // one cell further
+  {3, 0}                   // end of a long corridor
+};
+
+constexpr Offset coneOffset (int const di, int const i)
+{
+  return {
+    static_cast<int8_t> (sConeCells [i].depth * sLook [di][0].x + sConeCells [i].side * sLook [di][2].x),
+    static_cast<int8_t> (sConeCells [i].depth * sLook [di][0].y + sConeCells [i].side * sLook [di][2].y)
+  };
+}
+
+#define CONE(di) { \
+  coneOffset (di, 0), coneOffset (di, 1), coneOffset (di, 2), coneOffset (di, 3), \
+  coneOffset (di, 4), coneOffset (di, 5), coneOffset (di, 6) }
+
+// Relative cell offsets of the depth view per direction
+Offset constexpr sCone [4][sConeSize] = {
+  CONE (0), CONE (1), CONE (2), CONE (3)
+};
+
+#undef CONE
+
+// Greyscale of a wall by the distance of its face to the player
+uint8_t constexpr sShade [3] = {255, 96, 32};
+// Ghost pixel of the map, dimmer than the walls
+uint8_t constexpr sGhostShade = 64;
+
+// All 128 views pre-rendered at compile time, placed in flash (3.2 kB),
+// a frame costs the same whatever the view shows
+extern uint8_t const sViews [1 << sConeSize][25];
+
+// Outside the maze counts as wall, the view and the map reach past the border
+template <class Maze>
+bool isWall (Maze const& maze, int32_t const x, int32_t const y)
+{
+  auto const inside = x >= 0 && y >= 0 && x < maze.width () && y < maze.height ();
+  return !inside || maze.test (LayerVisible, x, y);
+}
+
+// A blocking wall in front of the player
+template <class Maze>
+bool isBlocked (Maze const& maze, int32_t const px, int32_t const py, uint8_t const di)
+{
+  MAZE_PROFILE_SCOPE (SiteIsBlocked);
+  auto const& look = sLook [di & 3];
+  return maze.test (LayerBlocking, px + look [0].x, py + look [0].y);
+}
+
+// View index of the cells in front of the player, the same cells whatever
+// is hidden behind a wall
+template <class Maze>
+uint8_t getView (Maze const& maze, int32_t const px, int32_t const py, uint8_t const di)
+{
+  auto const& cone = sCone [di & 3];
+  uint8_t view = 0;
+  for (int i = 0; i < sConeSize; ++i)
+    if (isWall (maze, px + cone [i].x, py + cone [i].y))
+      view |= 1 << i;
+  return view;
+}
+
+// Marks the own cell and the cells of a view not hidden behind a wall:
+// the first row, the next one through an open front and the end of an
+// open corridor. Costs the same on any level.
+void explore (Explored& explored, uint8_t view, int32_t px, int32_t py, uint8_t di);
+
+// Copies the frame of a view and lights the bottom middle pixel for a
+// ghost straight ahead in its open part, the nearer the brighter
+void drawView (uint8_t* pixels, uint8_t view, int32_t px, int32_t py, uint8_t di,
+               ghost::Race const& race);
+
+// The depth view of the player into pixels, its cells are explored too
+// unless explored is null
+template <class Maze>
+void render (uint8_t* pixels, Maze const& maze, Explored* explored,
+             int32_t const px, int32_t const py, uint8_t const di, ghost::Race const& race)
+{
+  MAZE_PROFILE_SCOPE (SiteRender);
+  auto const view = getView (maze, px, py, di);
+  if (explored)
+    explore (*explored, view, px, py, di);
+  drawView (pixels, view, px, py, di, race);
+}
+
+// Dims the free cells of the map the ghosts are on
+void drawMapGhosts (uint8_t* pixels, int32_t px, int32_t py, ghost::Race const& race);
+
+// The walls of the 5x5 cells around (px, py), only the explored ones
+// unless explored is null, and the ghosts
+template <class Maze>
+void drawMap (uint8_t* pixels, Maze const& maze, Explored const* explored,
+              int32_t const px, int32_t const py, ghost::Race const& race)
+{
+  MAZE_PROFILE_SCOPE (SiteDrawMap);
+  for (int32_t y = 0; y < 5; ++y)
+    for (int32_t x = 0; x < 5; ++x)
+    {
+      // -2 because of display center
+      auto const cx = px + x - 2;
+      auto const cy = py + y - 2;
+      auto const seen = !explored || explored->test (cx, cy);
+      pixels [y * 5 + x] = (seen && isWall (maze, cx, cy)) ? sShade [0] : 0;
+    }
+
+  drawMapGhosts (pixels, px, py, race);
+}
+
+}
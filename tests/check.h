@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Host checks of the game modules, each test is a program that exits with
+// 1 at the first check that fails
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      exit (1); \
+    } \
+  } \
+  while (false)
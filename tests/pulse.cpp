@@ -0,0 +1,112 @@
+// Checks of the fixed point pulse against the float math it replaced,
+// runs on the build host.
+
+#include "check.h"
+#include "pulse.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+uint8_t constexpr sFullScale = 25;
+// the longest walking distance to the goal the ratios are taken from
+uint32_t constexpr sMaxWalk = 200;
+// the norm is rounded down to Q16, the length then to whole ms
+float constexpr sLengthError = 1.f + static_cast<float> (maze::pulse::sSlowest) / maze::pulse::sQ16One;
+// ms a wake up may be off the float step: one for rounding to whole ms,
+// one as the shorter length makes the steps come earlier
+int constexpr sMaxWaitError = 2;
+// share of the samples a level may be one step off, in per mille
+uint32_t constexpr sMaxLevelDeviations = 10;
+
+// The float pulse of one distance ratio as the game computed it before
+struct FloatPulse {
+  explicit FloatPulse (float const norm)
+    : norm (norm)
+    , length (norm * 1200.f)
+    , slope ((1.f - norm) / length)
+  {
+  }
+
+  bool constant () const { return length < 50.f; }
+
+  uint8_t level (float const elapsed) const
+  {
+    return static_cast<uint8_t> (slope * elapsed * static_cast<float> (sFullScale));
+  }
+
+  float norm;
+  float length;
+  float slope;
+};
+
+struct Deviations {
+  uint32_t samples = 0;
+  uint32_t levels = 0;
+};
+
+// Every ms of the pulse of walk / maximum: the level of a channel is at
+// most one step off the float one, and when both agree the fixed point
+// wait ends next to the next float step or the next pulse start
+void checkRatio (uint32_t const walk, uint32_t const maximum, Deviations& deviations)
+{
+  auto const norm = maze::pulse::walkNorm (walk, maximum);
+  FloatPulse const reference (static_cast<float> (walk) / static_cast<float> (maximum));
+  CHECK (std::fabs (static_cast<float> (norm) / maze::pulse::sQ16One - reference.norm) <= 1.f / maze::pulse::sQ16One);
+
+  auto const length = maze::pulse::length (norm);
+  // the threshold may be crossed a bit earlier
+  if (std::fabs (reference.length - static_cast<float> (maze::pulse::sMinResolution)) >= sLengthError)
+    CHECK ((0 == length) == reference.constant ());
+  if (0 == length)
+    return;
+  CHECK (std::fabs (static_cast<float> (length) - reference.length) < sLengthError);
+
+  // float levels and the time of their next change, the pulse starts
+  // again after its length
+  std::vector<uint8_t> levels (length + 1);
+  std::vector<uint32_t> changes (length + 1);
+  for (uint32_t elapsed = 0; elapsed <= length; ++elapsed)
+    levels [elapsed] = reference.level (static_cast<float> (elapsed));
+  changes [length] = length + 1;
+  for (auto elapsed = length; elapsed-- > 0;)
+    changes [elapsed] = (levels [elapsed + 1] != levels [elapsed]) ? elapsed + 1 : changes [elapsed + 1];
+
+  for (uint32_t elapsed = 0; elapsed <= length; ++elapsed)
+  {
+    auto const level = (maze::pulse::intensity (norm, length, elapsed) * sFullScale) >> 16;
+    auto const expected = levels [elapsed];
+    CHECK (std::abs (static_cast<int> (level) - static_cast<int> (expected)) <= 1);
+
+    auto const wait = maze::pulse::wait (norm, length, elapsed, sFullScale);
+    CHECK (wait >= 1);
+    if (level == expected)
+      CHECK (std::abs (static_cast<int> (elapsed + wait) - static_cast<int> (changes [elapsed])) <= sMaxWaitError);
+
+    deviations.samples += 1;
+    deviations.levels += (level != expected) ? 1 : 0;
+  }
+}
+
+void checkPulse ()
+{
+  Deviations deviations;
+  for (uint32_t maximum = 1; maximum <= sMaxWalk; ++maximum)
+    for (uint32_t walk = 0; walk <= maximum; ++walk)
+      checkRatio (walk, maximum, deviations);
+
+  CHECK (deviations.samples > 0);
+  CHECK (deviations.levels * 1000ull <= deviations.samples * static_cast<uint64_t> (sMaxLevelDeviations));
+}
+
+}
+
+int main ()
+{
+  checkPulse ();
+  return 0;
+}
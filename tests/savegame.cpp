@@ -0,0 +1,361 @@
+// Stress of the flash save log on the build host: a million moves through
+// a file page with its compactions, power lost in the middle of writes
+// and single bits flipped in the saved words. Every eighth record changes
+// the doors and timed walls instead of moving. The explored cells are the
+// player cells modulo the explored size.
+
+#include "check.h"
+#include "savegame.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+
+using maze::save::FileFlash;
+using maze::save::Flash;
+using maze::save::State;
+
+char const* const sPath = "savegame_test.flash";
+uint32_t constexpr sRecords = 1000000;
+// the log is loaded and compared after this many records
+uint32_t constexpr sLoadInterval = 997;
+// power losses, each after a random number of words up to sMaxBudget
+uint32_t constexpr sTears = 2000;
+uint32_t constexpr sMaxBudget = 700;
+uint32_t constexpr sErased = 0xffffffff;
+int32_t constexpr sExploredSize = 64;
+
+int32_t constexpr sDx [4] = {0, 1, 0, -1};
+int32_t constexpr sDy [4] = {-1, 0, 1, 0};
+
+uint32_t sRandom = 1;
+
+// xorshift, the same sequence on every run
+uint32_t random ()
+{
+  sRandom ^= sRandom << 13;
+  sRandom ^= sRandom >> 17;
+  sRandom ^= sRandom << 5;
+  return sRandom;
+}
+
+struct Move {
+  bool moved;
+  uint8_t moveDi;
+  uint8_t di;
+  uint8_t mode;
+  // a walls record with these bits instead of a move
+  bool walls;
+  uint8_t doorBits;
+  uint8_t wallBits;
+};
+
+Move randomMove ()
+{
+  auto const bits = random ();
+  return {(bits & 1) != 0, static_cast<uint8_t> ((bits >> 1) & 3), static_cast<uint8_t> ((bits >> 3) & 3),
+    static_cast<uint8_t> ((bits >> 5) & 1), 0 == ((bits >> 6) & 7), static_cast<uint8_t> ((bits >> 9) & 15),
+    static_cast<uint8_t> ((bits >> 13) & 15)};
+}
+
+// The move as the game applies it to its player
+void apply (State& state, Move const& move)
+{
+  if (move.walls)
+  {
+    state.doors = move.doorBits;
+    state.walls = move.wallBits;
+    return;
+  }
+  if (move.moved)
+  {
+    state.px += sDx [move.moveDi];
+    state.py += sDy [move.moveDi];
+  }
+  state.di = move.di;
+  state.mode = move.mode;
+}
+
+void record (Move const& move)
+{
+  if (move.walls)
+    maze::save::recordWalls (move.doorBits, move.wallBits);
+  else
+    maze::save::record (move.moved, move.moveDi, move.di, move.mode);
+}
+
+maze::Explored sReplayed;
+
+void see (maze::Explored& explored, State const& state)
+{
+  explored.mark (state.px & (sExploredSize - 1), state.py & (sExploredSize - 1));
+}
+
+void replayed (State const& state)
+{
+  see (sReplayed, state);
+}
+
+bool same (maze::Explored const& a, maze::Explored const& b)
+{
+  return a.words () == b.words () && std::equal (a.data (), a.data () + a.words (), b.data ());
+}
+
+bool same (State const& a, State const& b)
+{
+  return a.source == b.source && a.level == b.level && a.seed == b.seed && a.px == b.px && a.py == b.py
+    && a.di == b.di && a.mode == b.mode && a.doors == b.doors && a.walls == b.walls;
+}
+
+State initial ()
+{
+  State state;
+  state.source = 1;
+  state.level = 3;
+  state.seed = 0x12345678;
+  state.px = 101;
+  state.py = 57;
+  state.di = 2;
+  state.mode = 0;
+  state.doors = 1;
+  state.walls = 2;
+  return state;
+}
+
+// An erased page in memory, its words can be changed at will
+class MemoryFlash : public Flash
+{
+public:
+  explicit MemoryFlash (uint32_t const words)
+    : mWords (words, sErased)
+  {
+  }
+
+  uint32_t words () const override { return static_cast<uint32_t> (mWords.size ()); }
+  uint32_t read (uint32_t const word) const override { return mWords [word]; }
+
+  void write (uint32_t const word, uint32_t const* data, uint32_t const count) override
+  {
+    for (uint32_t i = 0; i < count; ++i)
+      mWords [word + i] &= data [i];
+  }
+
+  void erase () override { mWords.assign (mWords.size (), sErased); }
+
+  void poke (uint32_t const word, uint32_t const value) { mWords [word] = value; }
+
+private:
+  std::vector<uint32_t> mWords;
+};
+
+// Passes writes on until the power is lost after a number of words. The
+// word written then keeps a random part of the bits it should clear,
+// nothing after it reaches the flash.
+class TornFlash : public Flash
+{
+public:
+  TornFlash (Flash& flash, uint32_t const budget)
+    : mFlash (flash)
+    , mBudget (budget)
+  {
+  }
+
+  // the power is gone
+  bool dead () const { return mDead; }
+  // erases that reached the flash
+  uint32_t erases () const { return mErases; }
+
+  uint32_t words () const override { return mFlash.words (); }
+  uint32_t read (uint32_t const word) const override { return mFlash.read (word); }
+
+  void write (uint32_t const word, uint32_t const* data, uint32_t const count) override
+  {
+    for (uint32_t i = 0; i < count && !mDead; ++i)
+    {
+      if (mBudget > 0)
+      {
+        mFlash.write (word + i, &data [i], 1);
+        --mBudget;
+        continue;
+      }
+      auto const torn = data [i] | (random () & ~data [i]);
+      mFlash.write (word + i, &torn, 1);
+      mDead = true;
+    }
+  }
+
+  void erase () override
+  {
+    if (mDead)
+      return;
+    mFlash.erase ();
+    ++mErases;
+  }
+
+private:
+  Flash& mFlash;
+  uint32_t mBudget;
+  bool mDead = false;
+  uint32_t mErases = 0;
+};
+
+// The state and the explored cells of the page are the expected ones
+void checkLoad (State const& expected, maze::Explored const& explored)
+{
+  State loaded;
+  sReplayed.reset (sExploredSize, sExploredSize);
+  CHECK (maze::save::load (loaded, &sReplayed, replayed));
+  CHECK (same (expected, loaded));
+  CHECK (same (explored, sReplayed));
+}
+
+// A million records, compared with the moves applied here
+void checkStress ()
+{
+  std::remove (sPath);
+  auto expected = initial ();
+  maze::Explored explored;
+  explored.reset (sExploredSize, sExploredSize);
+  see (explored, expected);
+  {
+    FileFlash flash (sPath);
+    maze::save::use (flash);
+    maze::save::start (expected, &explored);
+    for (uint32_t i = 0; i < sRecords; ++i)
+    {
+      // the game explores the view after the move was saved
+      auto const move = randomMove ();
+      record (move);
+      apply (expected, move);
+      see (explored, expected);
+      if (0 == i % sLoadInterval)
+        checkLoad (expected, explored);
+    }
+
+    // a word is written once per erase, the page is erased only when full
+    auto const& stats = flash.stats ();
+    CHECK (0 == stats.rewrites);
+    CHECK (stats.erases > sRecords / flash.words ());
+    CHECK (stats.erases < sRecords / (flash.words () / 4));
+    CHECK (stats.writes < sRecords + stats.erases * flash.words ());
+  }
+
+  // the file holds the game after a restart
+  FileFlash flash (sPath);
+  maze::save::use (flash);
+  checkLoad (expected, explored);
+  std::remove (sPath);
+}
+
+// Power lost in a write restores the state before or after the move that
+// was written, or nothing if it hit a compaction after the erase
+void checkTears ()
+{
+  for (uint32_t tear = 0; tear < sTears; ++tear)
+  {
+    std::remove (sPath);
+    std::vector<State> states {initial ()};
+    maze::Explored explored;
+    explored.reset (sExploredSize, sExploredSize);
+    // the power went in a compaction after its erase
+    bool blank = false;
+    {
+      FileFlash file (sPath);
+      TornFlash flash (file, random () % sMaxBudget);
+      maze::save::use (flash);
+      maze::save::start (states.back (), &explored);
+      blank = flash.dead ();
+      while (!flash.dead ())
+      {
+        auto const move = randomMove ();
+        auto next = states.back ();
+        apply (next, move);
+        auto const erases = flash.erases ();
+        record (move);
+        blank = erases != flash.erases ();
+        states.push_back (next);
+        see (explored, next);
+      }
+    }
+
+    FileFlash flash (sPath);
+    maze::save::use (flash);
+    State loaded;
+    if (!maze::save::load (loaded))
+    {
+      CHECK (blank);
+      continue;
+    }
+    auto const last = states.size () - 1;
+    CHECK (same (states [last], loaded) || (last > 0 && same (states [last - 1], loaded)));
+  }
+  std::remove (sPath);
+}
+
+// Every single flipped bit is noticed: in the snapshot nothing is loaded,
+// in a record the replay stops before it
+void checkCorruption ()
+{
+  uint32_t constexpr records = 20;
+  MemoryFlash flash (256);
+  maze::save::use (flash);
+  std::vector<State> states {initial ()};
+  // a few cells, no word looks erased
+  maze::Explored explored;
+  explored.reset (sExploredSize, sExploredSize);
+  for (int32_t i = 0; i < sExploredSize; ++i)
+    explored.mark (i, (i * 7) & (sExploredSize - 1));
+  maze::save::start (states.back (), &explored);
+
+  // the snapshot is what the start wrote
+  uint32_t snapshotWords = 0;
+  while (sErased != flash.read (snapshotWords))
+    ++snapshotWords;
+
+  for (uint32_t i = 0; i < records; ++i)
+  {
+    auto const move = randomMove ();
+    auto next = states.back ();
+    apply (next, move);
+    record (move);
+    states.push_back (next);
+  }
+
+  for (uint32_t word = 0; word < snapshotWords + records; ++word)
+    for (uint32_t bit = 0; bit < 32; ++bit)
+    {
+      auto damaged = flash;
+      damaged.poke (word, flash.read (word) ^ (1u << bit));
+      maze::save::use (damaged);
+      State loaded;
+      if (word < snapshotWords)
+        CHECK (!maze::save::load (loaded));
+      else
+      {
+        CHECK (maze::save::load (loaded));
+        CHECK (same (states [word - snapshotWords], loaded));
+      }
+    }
+
+  maze::save::use (flash);
+  State loaded;
+  maze::Explored restored;
+  restored.reset (sExploredSize, sExploredSize);
+  CHECK (maze::save::load (loaded, &restored));
+  CHECK (same (states.back (), loaded));
+  CHECK (same (explored, restored));
+}
+
+}
+
+int main ()
+{
+  checkCorruption ();
+  checkTears ();
+  checkStress ();
+  return 0;
+}
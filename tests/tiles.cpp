@@ -0,0 +1,193 @@
+// Checks of the tiles of the generated world, runs on the build host.
+
+#include "check.h"
+#include "tiles.h"
+#include "view.h"
+
+#include <cstdint>
+
+namespace
+{
+
+using maze::sTileSize;
+
+// 65536 x 65536 cells and the border
+int32_t constexpr sWorldTiles = 4096;
+uint32_t constexpr sWalkSteps = 100000;
+
+int32_t const sDx [4] = {0, 1, 0, -1};
+int32_t const sDy [4] = {-1, 0, 1, 0};
+
+bool test (maze::TileRows const& rows, maze::Layer const layer, int32_t const x, int32_t const y)
+{
+  return (rows [layer][y] >> x) & 1u;
+}
+
+// Floor neighbours of a cell inside the tile
+int openNeighbours (maze::TileRows const& rows, int32_t const x, int32_t const y)
+{
+  auto open = 0;
+  for (int di = 0; di < 4; ++di)
+  {
+    auto const nx = x + sDx [di];
+    auto const ny = y + sDy [di];
+    if (nx >= 0 && ny >= 0 && nx < sTileSize && ny < sTileSize && !test (rows, maze::LayerBlocking, nx, ny))
+      ++open;
+  }
+  return open;
+}
+
+// Every tile is a perfect maze of 8 x 8 cells with its doors west and
+// north, the special tiles only on cells and traps only in dead ends
+// away from the east and south border
+void checkTile (maze::GeneratedTiles const& world, int32_t const tx, int32_t const ty)
+{
+  maze::TileRows rows;
+  world.decode (tx, ty, rows);
+
+  // cells reachable from the upper left one, walls are never walked
+  uint16_t seen [sTileSize] = {};
+  int32_t stack [sTileSize * sTileSize];
+  int count = 0;
+  stack [count++] = 1 * sTileSize + 1;
+  seen [1] |= 1u << 1;
+  int32_t floor = 0;
+  while (count > 0)
+  {
+    auto const cell = stack [--count];
+    auto const x = cell % sTileSize;
+    auto const y = cell / sTileSize;
+    ++floor;
+    for (int di = 0; di < 4; ++di)
+    {
+      auto const nx = x + sDx [di];
+      auto const ny = y + sDy [di];
+      if (nx < 1 || ny < 1 || nx >= sTileSize || ny >= sTileSize ||
+          test (rows, maze::LayerBlocking, nx, ny) || ((seen [ny] >> nx) & 1u))
+        continue;
+      seen [ny] |= 1u << nx;
+      stack [count++] = ny * sTileSize + nx;
+    }
+  }
+  // 64 cells and the 63 passages between them
+  CHECK (64 + 63 == floor);
+
+  int32_t westDoors = 0;
+  int32_t northDoors = 0;
+  for (int32_t i = 0; i < sTileSize; ++i)
+  {
+    westDoors += test (rows, maze::LayerBlocking, 0, i) ? 0 : 1;
+    northDoors += test (rows, maze::LayerBlocking, i, 0) ? 0 : 1;
+  }
+  CHECK ((tx > 0 ? 1 : 0) == westDoors);
+  CHECK ((ty > 0 ? 1 : 0) == northDoors);
+
+  for (int32_t y = 0; y < sTileSize; ++y)
+    for (int32_t x = 0; x < sTileSize; ++x)
+    {
+      auto const trap = test (rows, maze::LayerTrap, x, y);
+      auto const twister = test (rows, maze::LayerTwister, x, y);
+      auto const dark = test (rows, maze::LayerDark, x, y);
+      if (!trap && !twister && !dark)
+        continue;
+
+      CHECK (1 == (x & 1) && 1 == (y & 1));
+      CHECK (!test (rows, maze::LayerBlocking, x, y));
+      CHECK ((trap ? 1 : 0) + (twister ? 1 : 0) + (dark ? 1 : 0) == 1);
+      if (trap)
+        CHECK (1 == openNeighbours (rows, x, y) && x < sTileSize - 1 && y < sTileSize - 1);
+      if (twister)
+        CHECK (openNeighbours (rows, x, y) > 1);
+    }
+}
+
+void checkTiles ()
+{
+  // the tiles of the east and south border of the world are included
+  int32_t constexpr tiles = 24;
+  for (uint32_t seed = 1; seed <= 8; ++seed)
+  {
+    maze::GeneratedTiles const world (seed, tiles, tiles);
+    for (int32_t ty = 0; ty < tiles; ++ty)
+      for (int32_t tx = 0; tx < tiles; ++tx)
+        checkTile (world, tx, ty);
+  }
+}
+
+// Walks from a cell of the world towards a direction, around the walls
+// in the way by the Pledge algorithm, and reads the view in all
+// directions on every cell, like the game does. The cache never holds
+// more than its slots, its size does not change and after the prefetch
+// of a step the view of the next one never decodes a tile.
+void checkWalk (int32_t const startX, int32_t const startY, uint8_t const heading)
+{
+  maze::GeneratedTiles const world (7, sWorldTiles, sWorldTiles);
+  maze::TileCache cache;
+  cache.reset (&world);
+  CHECK (sWorldTiles * sTileSize + 1 == cache.width ());
+  CHECK (sWorldTiles * sTileSize + 1 == cache.height ());
+
+  auto const bytes = cache.bytes ();
+  auto x = startX;
+  auto y = startY;
+  uint8_t di = heading;
+  // quarter turns along the wall, 0 when heading on
+  int turns = 0;
+  auto tx = x >> maze::sTileShift;
+  auto ty = y >> maze::sTileShift;
+  uint32_t tiles = 1;
+  cache.prefetch (x, y);
+  for (uint32_t step = 0; step < sWalkSteps; ++step)
+  {
+    auto const misses = cache.stats ().misses;
+    for (uint8_t look = 0; look < 4; ++look)
+      maze::getView (cache, x, y, look);
+    CHECK (misses == cache.stats ().misses);
+
+    // heading on until a wall, then along it with the right hand until
+    // the turns add up to the heading again
+    uint8_t const right = (di + 1) & 3;
+    if (0 != turns && !maze::isBlocked (cache, x, y, right))
+    {
+      di = right;
+      turns += 1;
+    }
+    else
+      while (maze::isBlocked (cache, x, y, di))
+      {
+        di = (di + 3) & 3;
+        turns -= 1;
+      }
+    x += sDx [di];
+    y += sDy [di];
+    cache.prefetch (x, y);
+
+    auto const& stats = cache.stats ();
+    CHECK (stats.misses - stats.evictions <= maze::TileCache::sCapacity);
+    CHECK (bytes == cache.bytes ());
+    if ((x >> maze::sTileShift) != tx || (y >> maze::sTileShift) != ty)
+    {
+      tx = x >> maze::sTileShift;
+      ty = y >> maze::sTileShift;
+      ++tiles;
+    }
+  }
+
+  // far more tiles than slots were walked through
+  CHECK (tiles > 20u * maze::TileCache::sCapacity);
+  CHECK (cache.stats ().evictions > 0);
+}
+
+}
+
+int main ()
+{
+  checkTiles ();
+  // from the start, the middle and the lower right corner of the world
+  auto const middle = sWorldTiles / 2 * sTileSize + 1;
+  auto const last = (sWorldTiles - 1) * sTileSize + 1;
+  checkWalk (1, 1, 1);
+  checkWalk (middle, middle, 2);
+  checkWalk (last, last, 3);
+  return 0;
+}
@@ -0,0 +1,639 @@
+// Benchmarks of the game paths, runs on the build host.
+//
+// Build with cmake, the maze_bench target, or:
+//   g++ -std=c++11 -O2 -Isource -o maze_bench tools/bench.cpp
+//       source/bitmaze.cpp source/distance.cpp source/explored.cpp
+//       source/generator.cpp source/ghost.cpp source/pulse.cpp
+//       source/view.cpp
+//
+// Usage:
+//   maze_bench [-r RUNS] [-w WARMUP] [-s SEED] [-l]
+//
+// Times the wall lookups of the bit planes against the old layout of a
+// vector per row, the view, map and pulse paths of the game, the pulse
+// against the float math it replaced, the view from the frame table
+// against the old one drawn pixel by pixel, the distance field and a
+// scripted game on generated levels of several sizes, and on a 512x512
+// level the repair of the distances after a wall changed against
+// computing them again. The generator is timed per level up to
+// 1025x1025, with -l up to 4097x4097, which takes about a minute more.
+// Every benchmark repeats its work for WARMUP runs that are not counted,
+// then for RUNS runs. Prints one CSV line per benchmark and size with the
+// median, mean and standard deviation of the time per operation, to
+// compare one commit with the next.
+
+#include "distance.h"
+#include "explored.h"
+#include "generator.h"
+#include "ghost.h"
+#include "profile.h"
+#include "pulse.h"
+#include "view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int32_t const sSizes [] = {15, 41, 101, 255, 1025};
+int32_t const sGeneratorSizes [] = {15, 101, 1025};
+int32_t constexpr sLargeGeneratorSize = 4097;
+// every run does at least this many operations, short ones are repeated
+uint32_t constexpr sMinOperations = 200000;
+// runs of work on a whole level cover at least this many cells
+uint32_t constexpr sMinCells = 250000;
+// level of the distance repair benchmarks and cells changed per run
+int32_t constexpr sWallSize = 512;
+uint32_t constexpr sChangingCells = 256;
+// the map is shown for one press in this many in the scripted game
+uint32_t constexpr sMapEvery = 8;
+uint8_t constexpr sFullScale = 25;
+
+int32_t const sDx [4] = {0, 1, 0, -1};
+int32_t const sDy [4] = {-1, 0, 1, 0};
+
+// Results of the benchmarks end up here, so the compiler keeps them
+uint32_t volatile sSink = 0;
+
+struct Options {
+  uint32_t runs = 15;
+  uint32_t warmup = 3;
+  uint32_t seed = 1;
+  bool large = false;
+};
+
+// The layout before the bit planes: a byte per tile in a vector per row
+using Rows = std::vector<std::vector<uint8_t>>;
+
+struct Level {
+  maze::BitMaze maze;
+  // the same tiles in the old layout
+  Rows rows;
+  maze::DistanceField distance;
+  maze::Endpoints ends;
+  // floor cells, the start of every benchmark position
+  std::vector<std::pair<int32_t, int32_t>> floor;
+};
+
+Level generate (int32_t const size, uint32_t const seed)
+{
+  maze::GeneratorConfig config;
+  config.seed = seed;
+  config.width = size;
+  config.height = size;
+
+  Level level;
+  level.ends = maze::generate (level.maze, level.distance, config);
+  level.distance.compute (level.maze, level.ends.ex, level.ends.ey);
+  level.rows.assign (level.maze.height (), std::vector<uint8_t> (level.maze.width ()));
+  for (int32_t y = 0; y < level.maze.height (); ++y)
+    for (int32_t x = 0; x < level.maze.width (); ++x)
+    {
+      level.rows [y][x] = level.maze.tile (x, y);
+      if (!level.maze.test (maze::LayerBlocking, x, y))
+        level.floor.emplace_back (x, y);
+    }
+  return level;
+}
+
+// Operations on a whole level of the size, for the minimum operations of
+// a run
+uint32_t levels (int32_t const size)
+{
+  return std::max<uint32_t> (1, sMinCells / static_cast<uint32_t> (size * size));
+}
+
+uint32_t sum (uint8_t const* pixels)
+{
+  uint32_t total = 0;
+  for (int i = 0; i < 25; ++i)
+    total += pixels [i];
+  return total;
+}
+
+// Runs work, which returns its number of operations, and prints the time
+// per operation as CSV
+template <class Work>
+void bench (Options const& options, char const* name, int32_t const size, Work work,
+            uint32_t const minOperations = sMinOperations)
+{
+  using Clock = std::chrono::steady_clock;
+
+  // one run of the work to learn how often to repeat it
+  auto const operations = std::max<uint32_t> (1, work ());
+  auto const repeat = (minOperations + operations - 1) / operations;
+
+  std::vector<double> times;
+  for (uint32_t run = 0; run < options.warmup + options.runs; ++run)
+  {
+    auto const begin = Clock::now ();
+    for (uint32_t i = 0; i < repeat; ++i)
+      work ();
+    auto const ns = std::chrono::duration<double, std::nano> (Clock::now () - begin).count ();
+    if (run >= options.warmup)
+      times.push_back (ns / (static_cast<double> (repeat) * operations));
+  }
+
+  double mean = 0.0;
+  for (auto const t : times)
+    mean += t;
+  mean /= times.size ();
+  double variance = 0.0;
+  for (auto const t : times)
+    variance += (t - mean) * (t - mean);
+  auto const deviation = std::sqrt (variance / times.size ());
+
+  std::sort (times.begin (), times.end ());
+  auto const middle = times.size () / 2;
+  auto const median = (times.size () & 1) ? times [middle] : (times [middle - 1] + times [middle]) / 2.0;
+
+  printf ("%s,%d,%lu,%lu,%.2f,%.2f,%.2f\n", name, size,
+          static_cast<unsigned long> (times.size ()),
+          static_cast<unsigned long> (repeat * operations), median, mean, deviation);
+  fflush (stdout);
+}
+
+// The visible wall of every cell
+uint32_t wallLookup (Level const& level)
+{
+  auto const& maze = level.maze;
+  uint32_t walls = 0;
+  for (int32_t y = 0; y < maze.height (); ++y)
+    for (int32_t x = 0; x < maze.width (); ++x)
+      walls += maze.test (maze::LayerVisible, x, y) ? 1 : 0;
+  sSink = sSink + walls;
+  return static_cast<uint32_t> (maze.width () * maze.height ());
+}
+
+uint32_t wallLookupRows (Level const& level)
+{
+  auto const& rows = level.rows;
+  uint32_t walls = 0;
+  for (auto const& row : rows)
+    for (auto const tile : row)
+      walls += (4 < tile) ? 1 : 0;
+  sSink = sSink + walls;
+  return static_cast<uint32_t> (level.maze.width () * level.maze.height ());
+}
+
+// The blocking wall in front and the visible walls in front, left and
+// right of every floor cell in every direction
+uint32_t mazePart (Level const& level)
+{
+  auto const& maze = level.maze;
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+    for (uint8_t di = 0; di < 4; ++di)
+    {
+      auto const& look = maze::sLook [di];
+      auto const x = cell.first;
+      auto const y = cell.second;
+      total += maze::isBlocked (maze, x, y, di) ? 1 : 0;
+      total += maze.test (maze::LayerVisible, x + look [0].x, y + look [0].y) ? 2 : 0;
+      total += maze.test (maze::LayerVisible, x + look [1].x, y + look [1].y) ? 4 : 0;
+      total += maze.test (maze::LayerVisible, x + look [2].x, y + look [2].y) ? 8 : 0;
+    }
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size () * 4);
+}
+
+// The same as getMazePart of the game did on the old layout
+uint32_t mazePartRows (Level const& level)
+{
+  auto const& maze = level.rows;
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+    for (uint8_t di = 0; di < 4; ++di)
+    {
+      auto const px = cell.first;
+      auto const py = cell.second;
+      bool blocked;
+      bool front;
+      bool left;
+      bool right;
+      switch (di)
+      {
+      case 0:
+        blocked = 8 < maze[py - 1][px + 0];
+        front = 4 < maze[py - 1][px + 0];
+        left = 4 < maze[py + 0][px - 1];
+        right = 4 < maze[py + 0][px + 1];
+        break;
+      case 2:
+        blocked = 8 < maze[py + 1][px + 0];
+        front = 4 < maze[py + 1][px + 0];
+        left = 4 < maze[py + 0][px + 1];
+        right = 4 < maze[py + 0][px - 1];
+        break;
+      case 3:
+        blocked = 8 < maze[py + 0][px - 1];
+        front = 4 < maze[py + 0][px - 1];
+        left = 4 < maze[py + 1][px + 0];
+        right = 4 < maze[py - 1][px + 0];
+        break;
+      default:
+        blocked = 8 < maze[py + 0][px + 1];
+        front = 4 < maze[py + 0][px + 1];
+        left = 4 < maze[py - 1][px + 0];
+        right = 4 < maze[py + 1][px + 0];
+        break;
+      }
+      total += (blocked ? 1 : 0) + (front ? 2 : 0) + (left ? 4 : 0) + (right ? 8 : 0);
+    }
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size () * 4);
+}
+
+// View, explored cells unless explored is null and frame of every floor
+// cell in every direction
+uint32_t image (Level const& level, maze::Explored* explored, maze::ghost::Race const& race)
+{
+  uint8_t pixels [25];
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+    for (uint8_t di = 0; di < 4; ++di)
+    {
+      maze::render (pixels, level.maze, explored, cell.first, cell.second, di, race);
+      total += sum (pixels);
+    }
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size () * 4);
+}
+
+// The 5x5 image of the old view, with the bounds check of setPixelValue
+// of the DAL and out of line like there
+class Image
+{
+public:
+  void clear () { memset (mPixels, 0, sizeof (mPixels)); }
+
+  __attribute__ ((noinline)) int setPixelValue (int16_t const x, int16_t const y, uint8_t const value)
+  {
+    if (x < 0 || y < 0 || x >= 5 || y >= 5)
+      return -1;
+    mPixels [y * 5 + x] = value;
+    return 0;
+  }
+
+  uint8_t const* pixels () const { return mPixels; }
+
+private:
+  uint8_t mPixels [25];
+};
+
+uint8_t constexpr sOldWall = 255;
+
+void setLeft (Image& image, bool const fill)
+{
+  image.setPixelValue (0, 0, sOldWall);
+  image.setPixelValue (0, 4, sOldWall);
+  if (fill)
+    for (int16_t i = 1; i < 4; ++i)
+      image.setPixelValue (0, i, sOldWall);
+}
+
+void setRight (Image& image, bool const fill)
+{
+  image.setPixelValue (4, 0, sOldWall);
+  image.setPixelValue (4, 4, sOldWall);
+  if (fill)
+    for (int16_t i = 1; i < 4; ++i)
+      image.setPixelValue (4, i, sOldWall);
+}
+
+void setMiddle (Image& image, bool const fill)
+{
+  for (int16_t i = 1; i < 4; ++i)
+  {
+    image.setPixelValue (i, 1, sOldWall);
+    image.setPixelValue (i, 3, sOldWall);
+  }
+  image.setPixelValue (1, 2, sOldWall);
+  image.setPixelValue (3, 2, sOldWall);
+  if (fill)
+    image.setPixelValue (2, 2, sOldWall);
+}
+
+// The old view of every floor cell in every direction: the walls next
+// to the player drawn pixel by pixel into a cleared image
+uint32_t imagePixels (Level const& level)
+{
+  auto const& maze = level.maze;
+  Image image;
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+    for (uint8_t di = 0; di < 4; ++di)
+    {
+      auto const& look = maze::sLook [di];
+      auto const x = cell.first;
+      auto const y = cell.second;
+      image.clear ();
+      setLeft (image, maze.test (maze::LayerVisible, x + look [1].x, y + look [1].y));
+      setMiddle (image, maze.test (maze::LayerVisible, x + look [0].x, y + look [0].y));
+      setRight (image, maze.test (maze::LayerVisible, x + look [2].x, y + look [2].y));
+      total += sum (image.pixels ());
+    }
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size () * 4);
+}
+
+// The map around every floor cell, with all cells or only the explored
+// ones
+uint32_t map (Level const& level, maze::Explored const* explored, maze::ghost::Race const& race)
+{
+  uint8_t pixels [25];
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+  {
+    maze::drawMap (pixels, level.maze, explored, cell.first, cell.second, race);
+    total += sum (pixels);
+  }
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size ());
+}
+
+// The pulse norm of every floor cell
+uint32_t distanceNorm (Level const& level)
+{
+  uint32_t total = 0;
+  for (auto const& cell : level.floor)
+    total += maze::pulse::walkNorm (level.distance.at (cell.first, cell.second), level.distance.maximum ());
+  sSink = sSink + total;
+  return static_cast<uint32_t> (level.floor.size ());
+}
+
+// One level of the generator with the next seed
+uint32_t generateLevel (maze::BitMaze& maze, maze::DistanceField& scratch,
+                        maze::GeneratorConfig& config)
+{
+  auto const ends = maze::generate (maze, scratch, config);
+  config.seed += 1;
+  sSink = sSink + static_cast<uint32_t> (ends.ex + ends.ey);
+  return 1;
+}
+
+// Brightness and wake up time of every ms of the pulses of a range of norms
+uint32_t pulseMath ()
+{
+  uint32_t operations = 0;
+  uint32_t total = 0;
+  for (uint32_t norm = 0; norm <= maze::pulse::sQ16One; norm += 1024)
+  {
+    auto const length = maze::pulse::length (norm);
+    for (uint32_t elapsed = 0; elapsed < length; ++elapsed)
+    {
+      auto const sample = maze::pulse::sample (norm, length, elapsed, sFullScale);
+      total += sample.intensity + sample.wait;
+      operations += 1;
+    }
+  }
+  sSink = sSink + total;
+  return operations;
+}
+
+// Only the Q16 intensity of every ms scaled to a channel, the work the
+// float pulse does
+uint32_t pulseIntensity ()
+{
+  uint32_t operations = 0;
+  uint32_t total = 0;
+  for (uint32_t norm = 0; norm <= maze::pulse::sQ16One; norm += 1024)
+  {
+    auto const length = maze::pulse::length (norm);
+    for (uint32_t elapsed = 0; elapsed < length; ++elapsed)
+    {
+      total += (maze::pulse::intensity (norm, length, elapsed) * sFullScale) >> 16;
+      operations += 1;
+    }
+  }
+  sSink = sSink + total;
+  return operations;
+}
+
+// The same pulses in the float math the game used before: the intensity
+// of every ms scaled to a channel of full scale
+uint32_t pulseFloat ()
+{
+  uint32_t operations = 0;
+  uint32_t total = 0;
+  for (uint32_t norm = 0; norm <= maze::pulse::sQ16One; norm += 1024)
+  {
+    auto const pulse = static_cast<float> (norm) / static_cast<float> (maze::pulse::sQ16One);
+    auto const maxPulse = pulse * static_cast<float> (maze::pulse::sSlowest);
+    auto const length = maze::pulse::length (norm);
+    for (uint32_t elapsed = 0; elapsed < length; ++elapsed)
+    {
+      auto const intensity = (1.f - pulse) * static_cast<float> (elapsed) / maxPulse;
+      total += static_cast<uint8_t> (intensity * static_cast<float> (sFullScale));
+      operations += 1;
+    }
+  }
+  sSink = sSink + total;
+  return operations;
+}
+
+// Walks from the start to the goal along the distance field, pressing
+// turn and step buttons like a player. Every press updates the view, the
+// explored cells and the pulse, some show the map. Twisters do not turn.
+uint32_t game (Level const& level, maze::Explored& explored, maze::ghost::Race const& race)
+{
+  auto const& maze = level.maze;
+  explored.reset (maze.width (), maze.height ());
+
+  int32_t px = level.ends.sx;
+  int32_t py = level.ends.sy;
+  uint8_t di = 0;
+  uint8_t pixels [25];
+  uint32_t presses = 0;
+  uint32_t total = 0;
+  auto const limit = static_cast<uint32_t> (maze.width () * maze.height () * 4);
+  while ((px != level.ends.ex || py != level.ends.ey) && presses < limit)
+  {
+    // the neighbour nearer to the goal, traps are never walked on
+    uint8_t next = di;
+    for (uint8_t d = 0; d < 4; ++d)
+    {
+      auto const nx = px + sDx [d];
+      auto const ny = py + sDy [d];
+      if (!maze.test (maze::LayerBlocking, nx, ny) && !maze.test (maze::LayerTrap, nx, ny) &&
+          level.distance.at (nx, ny) < level.distance.at (px, py))
+        next = d;
+    }
+
+    if (next != di)
+      di = static_cast<uint8_t> ((di + ((((next - di) & 3) == 3) ? 3 : 1)) & 3);
+    else if (!maze::isBlocked (maze, px, py, di))
+    {
+      px += sDx [di];
+      py += sDy [di];
+      explored.mark (px, py);
+    }
+
+    auto const norm = maze::pulse::walkNorm (level.distance.at (px, py), level.distance.maximum ());
+    auto const length = maze::pulse::length (norm);
+    if (0 != length)
+    {
+      auto const sample = maze::pulse::sample (norm, length, 0, sFullScale);
+      total += sample.intensity + sample.wait;
+    }
+
+    maze::render (pixels, maze, &explored, px, py, di, race);
+    total += sum (pixels);
+    if (0 == presses % sMapEvery)
+    {
+      maze::drawMap (pixels, maze, &explored, px, py, race);
+      total += sum (pixels);
+    }
+    presses += 1;
+  }
+  sSink = sSink + total;
+  return presses;
+}
+
+// A cell that turns into a wall or opens, and its tile in the level
+struct Change {
+  int32_t x;
+  int32_t y;
+  uint8_t tile;
+};
+
+// Random inner cells but the goal: walls open, the others close
+std::vector<Change> changes (Level const& level, uint32_t const seed)
+{
+  std::mt19937 random (seed);
+  std::vector<Change> changes;
+  auto const& maze = level.maze;
+  while (changes.size () < sChangingCells)
+  {
+    auto const x = static_cast<int32_t> (1 + random () % (maze.width () - 2));
+    auto const y = static_cast<int32_t> (1 + random () % (maze.height () - 2));
+    if (x != level.ends.ex || y != level.ends.ey)
+      changes.push_back ({x, y, maze.tile (x, y)});
+  }
+  return changes;
+}
+
+// Changes every cell and puts it back, with the distances repaired after
+// each change. Checks the distances against a full compute if asked.
+uint32_t repair (Level& level, std::vector<Change> const& changes, bool const check)
+{
+  maze::DistanceField full;
+  for (int pass = 0; pass < 2; ++pass)
+    for (auto const& change : changes)
+    {
+      auto const wall = maze::tileInLayer (maze::LayerBlocking, change.tile);
+      level.maze.setTile (change.x, change.y, (0 == pass) ? (wall ? 0 : 9) : change.tile);
+      level.distance.update (level.maze, change.x, change.y);
+      if (!check)
+        continue;
+
+      full.compute (level.maze, level.ends.ex, level.ends.ey);
+      bool same = full.maximum () == level.distance.maximum ();
+      for (int32_t y = 0; y < level.maze.height () && same; ++y)
+        for (int32_t x = 0; x < level.maze.width () && same; ++x)
+          same = full.at (x, y) == level.distance.at (x, y);
+      if (!same)
+      {
+        fprintf (stderr, "maze_bench: repaired distances differ after changing %d, %d\n", change.x, change.y);
+        exit (1);
+      }
+    }
+  sSink = sSink + level.distance.maximum ();
+  return static_cast<uint32_t> (changes.size () * 2);
+}
+
+}
+
+int main (int argc, char** argv)
+{
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv [i];
+    if ("-r" == arg && i + 1 < argc)
+      options.runs = static_cast<uint32_t> (std::max (1, atoi (argv [++i])));
+    else if ("-w" == arg && i + 1 < argc)
+      options.warmup = static_cast<uint32_t> (std::max (0, atoi (argv [++i])));
+    else if ("-s" == arg && i + 1 < argc)
+      options.seed = static_cast<uint32_t> (atoi (argv [++i]));
+    else if ("-l" == arg)
+      options.large = true;
+    else
+    {
+      fprintf (stderr, "usage: maze_bench [-r runs] [-w warmup] [-s seed] [-l]\n");
+      return 1;
+    }
+  }
+
+  // no ghosts, their loops still run
+  maze::ghost::Race const race {};
+
+  printf ("benchmark,size,runs,operations,median_ns,mean_ns,stddev_ns\n");
+  bench (options, "pulse", 0, [] { return pulseMath (); });
+  bench (options, "pulseIntensity", 0, [] { return pulseIntensity (); });
+  bench (options, "pulseFloat", 0, [] { return pulseFloat (); });
+  for (auto const size : sSizes)
+  {
+    auto const level = generate (size, options.seed);
+    maze::Explored explored;
+    explored.reset (level.maze.width (), level.maze.height ());
+    maze::DistanceField field;
+
+    bench (options, "wallLookup", size, [&] { return wallLookup (level); });
+    bench (options, "wallLookupRows", size, [&] { return wallLookupRows (level); });
+    bench (options, "getMazePart", size, [&] { return mazePart (level); });
+    bench (options, "getMazePartRows", size, [&] { return mazePartRows (level); });
+    bench (options, "updateImage", size, [&] { return image (level, &explored, race); });
+    bench (options, "updateImageOpen", size, [&] { return image (level, nullptr, race); });
+    bench (options, "updateImagePixels", size, [&] { return imagePixels (level); });
+    bench (options, "printMap", size, [&] { return map (level, &explored, race); });
+    bench (options, "printMapOpen", size, [&] { return map (level, nullptr, race); });
+    bench (options, "distanceCompute", size, [&] {
+      field.compute (level.maze, level.ends.ex, level.ends.ey);
+      return 1u;
+    }, levels (size));
+    bench (options, "getDistanceNorm", size, [&] { return distanceNorm (level); });
+    bench (options, "game", size, [&] { return game (level, explored, race); });
+  }
+
+  std::vector<int32_t> generatorSizes (std::begin (sGeneratorSizes), std::end (sGeneratorSizes));
+  if (options.large)
+    generatorSizes.push_back (sLargeGeneratorSize);
+  for (auto const size : generatorSizes)
+  {
+    maze::BitMaze maze;
+    maze::DistanceField scratch;
+    maze::GeneratorConfig config;
+    config.seed = options.seed;
+    config.width = size;
+    config.height = size;
+    bench (options, "generate", size, [&] { return generateLevel (maze, scratch, config); }, levels (size));
+    config.algorithm = maze::Wilson;
+    bench (options, "generateWilson", size, [&] { return generateLevel (maze, scratch, config); }, levels (size));
+  }
+
+  auto level = generate (sWallSize, options.seed);
+  auto const cells = changes (level, options.seed);
+  repair (level, cells, true);
+  maze::DistanceField full;
+  bench (options, "distanceCompute", sWallSize, [&] {
+    full.compute (level.maze, level.ends.ex, level.ends.ey);
+    return 1u;
+  }, levels (sWallSize));
+  bench (options, "distanceRepair", sWallSize, [&] { return repair (level, cells, false); },
+         2 * sChangingCells);
+#if MAZE_PROFILE
+  // the functions the benchmarks ran as one line of JSON
+  maze::profile::print ();
+#endif
+  return 0;
+}
@@ -0,0 +1,633 @@
+#include "difficulty.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace maze
+{
+
+namespace
+{
+
+float constexpr sNever = 1e9f;
+// bounds for solving the states of a twister or a group together
+uint32_t constexpr sTwisterPasses = 100;
+uint32_t constexpr sGroupPasses = 100;
+// largest group solved at once, two cells
+uint32_t constexpr sBlock = 8;
+// trap chances closer than this are the same
+float constexpr sTolerance = 1e-5f;
+// bound for the sweeps over all states
+uint32_t constexpr sSweeps = 1000;
+
+int32_t const sDx [4] = {0, 1, 0, -1};
+int32_t const sDy [4] = {-1, 0, 1, 0};
+
+// Up to three presses from a state: left, right and forward if not blocked
+struct Presses {
+  uint32_t count = 0;
+  // cell of the outcomes, the direction is added per outcome
+  uint32_t cell [3] = {};
+  uint8_t mask [3] = {};
+  // 1 for a trap, 2 for the goal, 0 otherwise
+  uint8_t end [3] = {};
+};
+
+// Directions a press facing di ends in: a twister turns away from it
+uint8_t outcomes (bool const twister, uint8_t const di)
+{
+  return twister ? (0xf & ~(1 << di)) : (1 << di);
+}
+
+struct Term {
+  // position of the state in the order
+  uint32_t at;
+  float weight;
+};
+
+// Sparse rows of a linear system over the states in an order, the value
+// of state i is constant [i] plus the weighted values of its terms.
+// Groups up to sBlock states are solved at once: their terms only name
+// states outside the group and inverse holds (1 - the weights inside)^-1
+// row by row from offset [group], ~0u for the larger groups.
+struct Chain {
+  std::vector<uint32_t> begin;
+  std::vector<Term> terms;
+  std::vector<float> constant;
+  std::vector<uint32_t> offset;
+  std::vector<float> inverse;
+};
+
+class Solver
+{
+public:
+  Solver (BitMaze const& maze, int32_t const ex, int32_t const ey)
+    : mMaze (maze), mWidth (maze.width ()), mHeight (maze.height ()), mGoal (ey * maze.width () + ex)
+  {
+  }
+
+  bool inside (int32_t const x, int32_t const y) const
+  {
+    return x >= 0 && y >= 0 && x < mWidth && y < mHeight;
+  }
+
+  bool active (uint32_t const cell) const
+  {
+    int32_t const x = cell % mWidth;
+    int32_t const y = cell / mWidth;
+    return cell != mGoal && !mMaze.test (LayerBlocking, x, y) && !mMaze.test (LayerTrap, x, y);
+  }
+
+  Presses presses (uint32_t const cell, uint8_t const di) const
+  {
+    Presses p;
+    int32_t const x = cell % mWidth;
+    int32_t const y = cell / mWidth;
+    auto const twister = mMaze.test (LayerTwister, x, y);
+    for (uint8_t turn : {3, 1})
+    {
+      p.cell [p.count] = cell;
+      p.mask [p.count] = outcomes (twister, (di + turn) & 3);
+      ++p.count;
+    }
+
+    auto const nx = x + sDx [di];
+    auto const ny = y + sDy [di];
+    if (!inside (nx, ny) || mMaze.test (LayerBlocking, nx, ny))
+      return p;
+
+    uint32_t const next = ny * mWidth + nx;
+    p.cell [p.count] = next;
+    p.mask [p.count] = outcomes (mMaze.test (LayerTwister, nx, ny), di);
+    p.end [p.count] = mMaze.test (LayerTrap, nx, ny) ? 1 : (next == mGoal ? 2 : 0);
+    ++p.count;
+    return p;
+  }
+
+  // Expected presses to the goal for press i
+  static float cost (std::vector<float> const& moves, Presses const& p, uint32_t const i)
+  {
+    if (1 == p.end [i])
+      return sNever;
+    return 1.0f + ((2 == p.end [i]) ? 0.0f : outcome (moves, p.cell [i], p.mask [i]));
+  }
+
+  // The press with the fewest expected presses, count if all end on traps
+  static uint32_t choose (std::vector<float> const& moves, Presses const& p)
+  {
+    uint32_t best = p.count;
+    float fewest = sNever;
+    for (uint32_t i = 0; i < p.count; ++i)
+    {
+      auto const value = cost (moves, p, i);
+      if (value < fewest)
+      {
+        fewest = value;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  // Settles the states outwards from the goal in the order of their value
+  // like a shortest path search, values start at sNever. The states of a
+  // twister are solved together when the first of them is reached. Exact
+  // unless a twister is left a way that is settled only after it, the
+  // iteration afterwards takes care of those.
+  template <typename Update>
+  uint32_t search (std::vector<float>& values, Update update) const
+  {
+    using Entry = std::pair<float, uint32_t>;
+    auto const size = static_cast<uint32_t> (values.size ());
+    std::vector<bool> done (size, false);
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    uint32_t updates = 0;
+
+    auto const reach = [&] (uint32_t const state)
+    {
+      if (done [state] || !active (state / 4))
+        return;
+      ++updates;
+      auto const value = update (state);
+      if (value >= values [state])
+        return;
+      values [state] = value;
+      queue.emplace (value, state);
+    };
+
+    // the states that can end in the given one: turns on the same cell
+    // and steps from the cells around
+    auto const previous = [&] (uint32_t const state)
+    {
+      uint32_t const cell = state / 4;
+      int32_t const x = cell % mWidth;
+      int32_t const y = cell / mWidth;
+      for (uint8_t d = 0; d < 4; ++d)
+      {
+        reach (cell * 4 + d);
+        if (inside (x - sDx [d], y - sDy [d]))
+          reach (((y - sDy [d]) * mWidth + x - sDx [d]) * 4 + d);
+      }
+    };
+
+    previous (mGoal * 4);
+    while (!queue.empty ())
+    {
+      auto const entry = queue.top ();
+      queue.pop ();
+      auto const state = entry.second;
+      if (done [state] || entry.first > values [state])
+        continue;
+
+      uint32_t const cell = state / 4;
+      if (!mMaze.test (LayerTwister, cell % mWidth, cell / mWidth))
+      {
+        done [state] = true;
+        previous (state);
+        continue;
+      }
+
+      // a twister loops between its states, this converges as every pass
+      // shrinks the error by a third at least
+      for (uint32_t other = cell * 4; other < cell * 4 + 4; ++other)
+        values [other] = std::min (values [other], values [state] + 4.0f);
+      bool changed = true;
+      for (uint32_t pass = 0; changed && pass < sTwisterPasses; ++pass)
+      {
+        changed = false;
+        for (uint32_t other = cell * 4; other < cell * 4 + 4; ++other)
+        {
+          ++updates;
+          auto const value = update (other);
+          changed = changed || std::fabs (value - values [other]) > 1e-6f * values [other];
+          values [other] = value;
+        }
+      }
+      for (uint32_t other = cell * 4; other < cell * 4 + 4; ++other)
+        done [other] = true;
+      for (uint32_t other = cell * 4; other < cell * 4 + 4; ++other)
+        previous (other);
+    }
+    return updates;
+  }
+
+  // Mean of the values of the outcome directions
+  static float outcome (std::vector<float> const& values, uint32_t const cell, uint8_t const mask)
+  {
+    float sum = 0;
+    uint32_t count = 0;
+    for (uint8_t d = 0; d < 4; ++d)
+      if (mask & (1 << d))
+      {
+        sum += values [cell * 4 + d];
+        ++count;
+      }
+    return sum / count;
+  }
+
+  // Updates the states lowest value first until no value changes by more
+  // than the tolerance. A state mostly depends on states with lower values,
+  // so in this order the states behind a change are updated only after it
+  // settled.
+  template <typename Update>
+  uint32_t iterate (std::vector<float>& values, Update update) const
+  {
+    using Entry = std::pair<float, uint32_t>;
+    auto const size = static_cast<uint32_t> (values.size ());
+    uint32_t updates = 0;
+
+    // the value a state would get now if it differs from the current one
+    auto const pending = [&] (uint32_t const state, float& next)
+    {
+      ++updates;
+      next = update (state);
+      auto const old = values [state];
+      return next - old > 1e-4f + old * 1e-6f || old - next > 1e-4f + old * 1e-6f;
+    };
+
+    std::vector<bool> queued (size, false);
+    std::vector<Entry> entries;
+    for (uint32_t state = 0; state < size; ++state)
+    {
+      float next;
+      if (values [state] < sNever && pending (state, next))
+      {
+        entries.emplace_back (next, state);
+        queued [state] = true;
+      }
+    }
+    // every state is queued at most once at a time
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue (
+      std::greater<Entry> (), std::move (entries));
+
+    while (!queue.empty ())
+    {
+      auto const entry = queue.top ();
+      auto const state = entry.second;
+      queue.pop ();
+
+      float next;
+      auto const changed = pending (state, next);
+      // queued with a smaller value than it has now, wait for its turn
+      if (changed && next > entry.first && !queue.empty () && queue.top ().first < next)
+      {
+        queue.emplace (next, state);
+        continue;
+      }
+      queued [state] = false;
+      if (!changed)
+        continue;
+
+      values [state] = next;
+
+      uint32_t const cell = state / 4;
+      int32_t const x = cell % mWidth;
+      int32_t const y = cell / mWidth;
+      // the states that can end in this one: turns on the same cell and
+      // steps from the cells around
+      uint32_t from [8];
+      uint32_t count = 0;
+      for (uint8_t d = 0; d < 4; ++d)
+      {
+        from [count++] = cell * 4 + d;
+        if (inside (x - sDx [d], y - sDy [d]))
+          from [count++] = ((y - sDy [d]) * mWidth + x - sDx [d]) * 4 + d;
+      }
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        auto const previous = from [i];
+        if (queued [previous] || values [previous] >= sNever || !pending (previous, next))
+          continue;
+        queued [previous] = true;
+        queue.emplace (next, previous);
+      }
+    }
+    return updates;
+  }
+
+  // Groups the cells that depend on each other when following the best
+  // presses, by Tarjan's strongly connected components. The groups come
+  // after all groups they depend on, starting at the goal. Returns the
+  // states in this order, group i starts at groups [i].
+  std::vector<uint32_t> components (std::vector<float> const& moves, std::vector<uint32_t>& groups) const
+  {
+    auto const cells = static_cast<uint32_t> (moves.size () / 4);
+    uint32_t constexpr unvisited = ~0u;
+    std::vector<uint32_t> index (cells, unvisited);
+    std::vector<uint32_t> low (cells, 0);
+    std::vector<bool> stacked (cells, false);
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> order;
+    groups.clear ();
+
+    // recursion on the heap, cells are far too many for the call stack
+    struct Frame {
+      uint32_t cell;
+      uint32_t count;
+      uint32_t next;
+      uint32_t edges [4];
+    };
+    std::vector<Frame> frames;
+    uint32_t counter = 0;
+
+    auto const visit = [&] (uint32_t const cell)
+    {
+      index [cell] = low [cell] = counter++;
+      stack.push_back (cell);
+      stacked [cell] = true;
+      Frame frame {cell, 0, 0, {}};
+      for (uint32_t state = cell * 4; state < cell * 4 + 4; ++state)
+      {
+        if (moves [state] >= sNever)
+          continue;
+        auto const p = presses (cell, state & 3);
+        auto const best = choose (moves, p);
+        if (best < p.count && 0 == p.end [best] && p.cell [best] != cell)
+          frame.edges [frame.count++] = p.cell [best];
+      }
+      frames.push_back (frame);
+    };
+
+    for (uint32_t root = 0; root < cells; ++root)
+    {
+      if (unvisited != index [root] || key (moves, root) >= sNever)
+        continue;
+      visit (root);
+      while (!frames.empty ())
+      {
+        auto& frame = frames.back ();
+        if (frame.next < frame.count)
+        {
+          auto const next = frame.edges [frame.next++];
+          if (unvisited == index [next])
+            visit (next);
+          else if (stacked [next])
+            low [frame.cell] = std::min (low [frame.cell], index [next]);
+          continue;
+        }
+
+        auto const cell = frame.cell;
+        frames.pop_back ();
+        if (!frames.empty ())
+          low [frames.back ().cell] = std::min (low [frames.back ().cell], low [cell]);
+        if (low [cell] != index [cell])
+          continue;
+
+        groups.push_back (static_cast<uint32_t> (order.size ()));
+        uint32_t member;
+        do
+        {
+          member = stack.back ();
+          stack.pop_back ();
+          stacked [member] = false;
+          for (uint32_t state = member * 4; state < member * 4 + 4; ++state)
+            if (moves [state] < sNever)
+              order.push_back (state);
+        }
+        while (member != cell);
+      }
+    }
+    groups.push_back (static_cast<uint32_t> (order.size ()));
+    return order;
+  }
+
+  // The trap chance of the states in the given order as a linear system:
+  // the best press, or a random one every sSlipPresses press
+  Chain chain (std::vector<float> const& moves, std::vector<uint32_t> const& order,
+               std::vector<uint32_t> const& groups) const
+  {
+    Chain c;
+    std::vector<uint32_t> position (moves.size (), ~0u);
+    for (uint32_t i = 0; i < order.size (); ++i)
+      position [order [i]] = i;
+
+    float constexpr slip = 1.0f / sSlipPresses;
+    c.begin.reserve (order.size () + 1);
+    c.constant.reserve (order.size ());
+    c.terms.reserve (order.size () * 3);
+    c.offset.reserve (groups.size ());
+    for (size_t group = 0; group + 1 < groups.size (); ++group)
+    {
+      auto const first = groups [group];
+      auto const size = groups [group + 1] - first;
+      auto const block = size <= sBlock;
+      // 1 - the weights inside the group, row major
+      double inside [sBlock][sBlock] = {};
+      for (uint32_t i = 0; block && i < size; ++i)
+        inside [i][i] = 1.0;
+
+      for (auto i = first; i < first + size; ++i)
+      {
+        auto const row = c.terms.size ();
+        c.begin.push_back (static_cast<uint32_t> (row));
+        float constant = 0;
+        auto const p = presses (order [i] / 4, order [i] & 3);
+        auto const best = choose (moves, p);
+        for (uint32_t press = 0; press < p.count; ++press)
+        {
+          auto const weight = slip / p.count + ((press == best) ? 1.0f - slip : 0.0f);
+          if (1 == p.end [press])
+            constant += weight;
+          if (0 != p.end [press])
+            continue;
+
+          uint32_t outcomes = 0;
+          for (uint8_t d = 0; d < 4; ++d)
+            outcomes += (p.mask [press] >> d) & 1;
+          for (uint8_t d = 0; d < 4; ++d)
+          {
+            if (!((p.mask [press] >> d) & 1))
+              continue;
+            // states that never reach the goal end on a trap
+            auto const at = position [p.cell [press] * 4 + d];
+            if (~0u == at)
+            {
+              constant += weight / outcomes;
+              continue;
+            }
+            if (block && at >= first && at < first + size)
+            {
+              inside [i - first][at - first] -= weight / outcomes;
+              continue;
+            }
+            auto term = c.terms.begin () + row;
+            while (term != c.terms.end () && term->at != at)
+              ++term;
+            if (term == c.terms.end ())
+              c.terms.push_back (Term {at, weight / outcomes});
+            else
+              term->weight += weight / outcomes;
+          }
+        }
+        c.constant.push_back (constant);
+      }
+
+      if (!block)
+      {
+        c.offset.push_back (~0u);
+        continue;
+      }
+      c.offset.push_back (static_cast<uint32_t> (c.inverse.size ()));
+      invert (inside, size);
+      for (uint32_t i = 0; i < size; ++i)
+        for (uint32_t j = 0; j < size; ++j)
+          c.inverse.push_back (static_cast<float> (inside [i][j]));
+    }
+    c.begin.push_back (static_cast<uint32_t> (c.terms.size ()));
+    return c;
+  }
+
+  // Gauss-Jordan elimination in place. The matrix is diagonally dominant,
+  // the weights of a row add up to 1 at most, so no pivoting is needed.
+  static void invert (double (&m) [sBlock][sBlock], uint32_t const size)
+  {
+    double r [sBlock][sBlock] = {};
+    for (uint32_t i = 0; i < size; ++i)
+      r [i][i] = 1.0;
+    for (uint32_t k = 0; k < size; ++k)
+    {
+      auto const pivot = m [k][k];
+      for (uint32_t j = 0; j < size; ++j)
+      {
+        m [k][j] /= pivot;
+        r [k][j] /= pivot;
+      }
+      for (uint32_t i = 0; i < size; ++i)
+      {
+        if (i == k)
+          continue;
+        auto const factor = m [i][k];
+        for (uint32_t j = 0; j < size; ++j)
+        {
+          m [i][j] -= factor * m [k][j];
+          r [i][j] -= factor * r [k][j];
+        }
+      }
+    }
+    for (uint32_t i = 0; i < size; ++i)
+      for (uint32_t j = 0; j < size; ++j)
+        m [i][j] = r [i][j];
+  }
+
+  // Block Gauss-Seidel sweeps over the groups until no value changes by
+  // more than the tolerance. Only slips lead to states of later groups.
+  static uint32_t sweep (Chain const& c, std::vector<uint32_t> const& groups, std::vector<float>& values)
+  {
+    uint32_t updates = 0;
+    bool changed = true;
+    for (uint32_t pass = 0; changed && pass < sSweeps; ++pass)
+    {
+      changed = false;
+      for (size_t group = 0; group + 1 < groups.size (); ++group)
+      {
+        auto const first = groups [group];
+        auto const size = groups [group + 1] - first;
+        auto const row = [&] (uint32_t const i)
+        {
+          auto value = c.constant [i];
+          for (auto t = c.begin [i]; t < c.begin [i + 1]; ++t)
+            value += c.terms [t].weight * values [c.terms [t].at];
+          return value;
+        };
+
+        if (~0u != c.offset [group])
+        {
+          float rhs [sBlock];
+          for (uint32_t i = 0; i < size; ++i)
+            rhs [i] = row (first + i);
+          auto const* inverse = &c.inverse [c.offset [group]];
+          for (uint32_t i = 0; i < size; ++i)
+          {
+            float value = 0;
+            for (uint32_t j = 0; j < size; ++j)
+              value += inverse [i * size + j] * rhs [j];
+            changed = changed || std::fabs (value - values [first + i]) > sTolerance;
+            values [first + i] = value;
+          }
+          updates += size;
+          continue;
+        }
+
+        bool again = true;
+        for (uint32_t local = 0; again && local < sGroupPasses; ++local)
+        {
+          again = false;
+          for (auto i = first; i < first + size; ++i)
+          {
+            auto const value = row (i);
+            auto const change = std::fabs (value - values [i]);
+            changed = changed || change > sTolerance;
+            // settle well below the tolerance, or what is left travels
+            // through all groups behind this one in the next sweep
+            again = again || change > sTolerance / 64;
+            values [i] = value;
+          }
+          updates += size;
+        }
+      }
+    }
+    return updates;
+  }
+
+  // Fewest expected presses of the states of a cell
+  static float key (std::vector<float> const& moves, uint32_t const cell)
+  {
+    return std::min (std::min (moves [cell * 4], moves [cell * 4 + 1]),
+                     std::min (moves [cell * 4 + 2], moves [cell * 4 + 3]));
+  }
+
+private:
+  BitMaze const& mMaze;
+  int32_t const mWidth;
+  int32_t const mHeight;
+  uint32_t const mGoal;
+};
+
+}
+
+Difficulty solve (BitMaze const& maze,
+                  int32_t const sx, int32_t const sy, uint8_t const sd,
+                  int32_t const ex, int32_t const ey)
+{
+  Difficulty result;
+  auto const cells = static_cast<uint32_t> (maze.width ()) * maze.height ();
+  Solver const solver (maze, ex, ey);
+
+  std::vector<float> moves (cells * 4, sNever);
+  auto const step = [&] (uint32_t const state)
+  {
+    auto const p = solver.presses (state / 4, state & 3);
+    auto const best = Solver::choose (moves, p);
+    return (best < p.count) ? Solver::cost (moves, p, best) : sNever;
+  };
+  result.updates += solver.search (moves, step);
+  result.updates += solver.iterate (moves, step);
+
+  // trap chance of the states that reach the goal, in an order in which
+  // one sweep gets most of it and only what slips lead to comes a sweep
+  // later
+  std::vector<uint32_t> groups;
+  auto const order = solver.components (moves, groups);
+  std::vector<float> traps (order.size (), 0.0f);
+  result.updates += Solver::sweep (solver.chain (moves, order, groups), groups, traps);
+
+  uint32_t const start = (sy * maze.width () + sx) * 4 + (sd & 3);
+  if (sx == ex && sy == ey)
+  {
+    result.solved = true;
+    return result;
+  }
+  result.solved = moves [start] < sNever;
+  result.moves = result.solved ? moves [start] : 0.0f;
+  result.trapChance = 1.0f;
+  for (uint32_t i = 0; result.solved && i < order.size (); ++i)
+    if (order [i] == start)
+      result.trapChance = traps [i];
+  return result;
+}
+
+}
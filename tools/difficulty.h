@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bitmaze.h"
+
+#include <cstdint>
+
+namespace maze
+{
+
+struct Difficulty {
+  // goal reachable without traps
+  bool solved = false;
+  // expected button presses to the goal for a player who knows the maze,
+  // twisters make it more than the walking distance plus turns
+  float moves = 0;
+  // chance of ending on a trap for the same player pressing a random
+  // button every sSlipPresses press
+  float trapChance = 0;
+  // state updates until both values settled
+  uint32_t updates = 0;
+};
+
+uint32_t constexpr sSlipPresses = 8;
+
+// Solves the Markov chain over (cell, direction) states with turns,
+// forward steps and twisters, which pick one of the other three directions
+// after every press on them. The expected presses come from a shortest path
+// search outwards from the goal that solves each twister as a whole, then
+// value iteration fixes the states it settled too early. The trap chance
+// follows from block Gauss-Seidel sweeps in the order of the best presses.
+Difficulty solve (BitMaze const& maze, int32_t sx, int32_t sy, uint8_t sd, int32_t ex, int32_t ey);
+
+}
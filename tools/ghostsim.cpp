@@ -0,0 +1,268 @@
+// Ghost race simulator, runs on the build host.
+//
+// Build:
+//   g++ -std=c++11 -O2 -Isource -o ghostsim tools/ghostsim.cpp
+//       source/bitmaze.cpp source/distance.cpp source/generator.cpp
+//       source/levelpack.cpp source/ghost.cpp
+//
+// Usage:
+//   ghostsim [-p PLAYERS] [-l LOSS] [-t SECONDS] [-r SEED] [level]
+//
+// Players walk randomly through the level, a text file or a gen: spec as
+// for levelpack, and race each other over a loopback stand-in for the
+// radio. It loses LOSS percent of the packets for every receiver and, like
+// the radio, keeps only a few unread packets. Reports the packets sent and
+// how long each player saw the others where they really were.
+
+#include "ghost.h"
+#include "levelio.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <random>
+
+namespace tools
+{
+
+void fail (std::string const& message)
+{
+  fprintf (stderr, "ghostsim: %s\n", message.c_str ());
+  exit (1);
+}
+
+}
+
+namespace
+{
+
+using maze::ghost::Race;
+
+// received packets the radio keeps until they are read
+size_t constexpr sQueue = 4;
+// a press every 150 to 600 ms
+uint32_t constexpr sMinPress = 150;
+uint32_t constexpr sPressRange = 450;
+uint32_t constexpr sTick = 10 /*ms*/;
+
+int32_t const sDx [4] = {0, 1, 0, -1};
+int32_t const sDy [4] = {-1, 0, 1, 0};
+
+using Packet = std::vector<uint8_t>;
+
+class Loopback;
+
+// Delivers every packet to all other players, or loses it
+class Hub
+{
+public:
+  Hub (double const loss, std::mt19937& random) : mLoss (loss), mRandom (random) {}
+
+  void add (Loopback* endpoint) { mEndpoints.push_back (endpoint); }
+  void broadcast (Loopback const* from, uint8_t const* data, uint8_t size);
+
+  uint64_t lost = 0;
+  uint64_t overflows = 0;
+
+private:
+  double mLoss;
+  std::mt19937& mRandom;
+  std::vector<Loopback*> mEndpoints;
+};
+
+class Loopback : public maze::ghost::Transport
+{
+public:
+  explicit Loopback (Hub& hub) : mHub (hub) { hub.add (this); }
+
+  void send (uint8_t const* data, uint8_t const size) override
+  {
+    mHub.broadcast (this, data, size);
+  }
+
+  uint8_t receive (uint8_t* data, uint8_t const capacity) override
+  {
+    if (mInbox.empty ())
+      return 0;
+    auto const size = static_cast<uint8_t> (std::min<size_t> (capacity, mInbox.front ().size ()));
+    std::copy (mInbox.front ().begin (), mInbox.front ().begin () + size, data);
+    mInbox.pop_front ();
+    return size;
+  }
+
+  bool deliver (uint8_t const* data, uint8_t const size)
+  {
+    if (mInbox.size () >= sQueue)
+      return false;
+    mInbox.emplace_back (data, data + size);
+    return true;
+  }
+
+private:
+  Hub& mHub;
+  std::deque<Packet> mInbox;
+};
+
+void Hub::broadcast (Loopback const* from, uint8_t const* data, uint8_t const size)
+{
+  std::uniform_real_distribution<double> chance (0.0, 1.0);
+  for (auto* endpoint : mEndpoints)
+  {
+    if (endpoint == from)
+      continue;
+    if (chance (mRandom) < mLoss)
+      lost += 1;
+    else if (!endpoint->deliver (data, size))
+      overflows += 1;
+  }
+}
+
+struct Player {
+  maze::ghost::Position position;
+  uint32_t nextPress = 0;
+  std::unique_ptr<Loopback> transport;
+  Race race;
+};
+
+// One random press: mostly forward, traps are avoided
+void press (Player& player, maze::BitMaze const& maze, std::mt19937& random)
+{
+  auto& position = player.position;
+  auto const choice = random () % 4;
+  auto const nx = position.px + sDx [position.di];
+  auto const ny = position.py + sDy [position.di];
+  if (choice >= 2 && !maze.test (maze::LayerBlocking, nx, ny) && !maze.test (maze::LayerTrap, nx, ny))
+  {
+    auto const moveDi = position.di;
+    position.px = nx;
+    position.py = ny;
+    if (maze.test (maze::LayerTwister, nx, ny))
+      position.di = static_cast<uint8_t> ((position.di + 1 + random () % 3) & 3);
+    player.race.step (moveDi, position.di);
+  }
+  else
+  {
+    position.di = static_cast<uint8_t> ((position.di + ((1 == choice) ? 1 : 3)) & 3);
+    player.race.turn (position.di);
+  }
+}
+
+}
+
+int main (int argc, char** argv)
+{
+  size_t count = 4;
+  double loss = 0.2;
+  uint32_t seconds = 60;
+  uint32_t seed = 1;
+  std::string spec = "gen:1:41x41";
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv [i];
+    if ("-p" == arg && i + 1 < argc)
+      count = std::max (2, atoi (argv [++i]));
+    else if ("-l" == arg && i + 1 < argc)
+      loss = atof (argv [++i]) / 100.0;
+    else if ("-t" == arg && i + 1 < argc)
+      seconds = static_cast<uint32_t> (std::max (1, atoi (argv [++i])));
+    else if ("-r" == arg && i + 1 < argc)
+      seed = static_cast<uint32_t> (atoi (argv [++i]));
+    else if ('-' == arg [0])
+      tools::fail ("usage: ghostsim [-p players] [-l loss] [-t seconds] [-r seed] [level]");
+    else
+      spec = arg;
+  }
+
+  auto const level = (0 == spec.compare (0, 4, "gen:")) ? tools::generate (spec) : tools::readText (spec);
+  maze::BitMaze bitMaze;
+  bitMaze.assign (level.tiles.data (), level.info.width, level.info.height);
+
+  std::mt19937 random (seed);
+  Hub hub (loss, random);
+  std::vector<Player> players (count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto& player = players [i];
+    player.position.px = level.info.sx;
+    player.position.py = level.info.sy;
+    player.position.di = level.info.sd;
+    player.nextPress = static_cast<uint32_t> (random () % sPressRange);
+    player.transport.reset (new Loopback (hub));
+    player.race.start (player.transport.get (), static_cast<uint16_t> (i + 1), 1, player.position, 0);
+  }
+
+  // per pair of players: ticks seen right, current and longest time seen wrong
+  uint64_t samples = 0;
+  uint64_t right = 0;
+  std::vector<uint32_t> wrongSince (count * count, 0);
+  uint32_t longest = 0;
+
+  auto const end = seconds * 1000;
+  for (uint32_t now = 0; now < end; now += sTick)
+  {
+    for (auto& player : players)
+      if (now >= player.nextPress)
+      {
+        press (player, bitMaze, random);
+        player.nextPress = now + sMinPress + static_cast<uint32_t> (random () % sPressRange);
+      }
+
+    // the race fiber sends, the radio event handler receives right away
+    if (0 == now % maze::ghost::sBatchInterval)
+      for (auto& player : players)
+      {
+        player.race.send (now);
+        player.race.expire (now);
+      }
+    for (auto& player : players)
+      player.race.receive (now);
+
+    for (size_t i = 0; i < count; ++i)
+      for (size_t j = 0; j < count; ++j)
+      {
+        if (i == j)
+          continue;
+        auto const& other = players [j].position;
+        bool seen = false;
+        for (uint8_t g = 0; g < maze::ghost::sMaxGhosts; ++g)
+        {
+          auto const& ghost = players [i].race.ghosts () [g];
+          if (ghost.active && ghost.id == j + 1)
+            seen = ghost.position.px == other.px && ghost.position.py == other.py &&
+                   ghost.position.di == other.di;
+        }
+
+        samples += 1;
+        auto& since = wrongSince [i * count + j];
+        if (seen)
+        {
+          right += 1;
+          since = now + sTick;
+        }
+        else
+          longest = std::max (longest, now + sTick - since);
+      }
+  }
+
+  Race::Stats total;
+  for (auto const& player : players)
+  {
+    total.keys += player.race.stats ().keys;
+    total.deltas += player.race.stats ().deltas;
+    total.bytes += player.race.stats ().bytes;
+    total.received += player.race.stats ().received;
+    total.gaps += player.race.stats ().gaps;
+  }
+
+  auto const perPlayer = static_cast<double> (count) * seconds;
+  printf ("%zu players, %.0f%% loss, %u s, %s\n", count, loss * 100.0, seconds, spec.c_str ());
+  printf ("per player: %.1f keys/s, %.1f deltas/s, %.0f bytes/s\n",
+          total.keys / perPlayer, total.deltas / perPlayer, total.bytes / perPlayer);
+  printf ("%lu received, %lu lost, %lu queue overflows, %lu gaps\n",
+          static_cast<unsigned long> (total.received), static_cast<unsigned long> (hub.lost),
+          static_cast<unsigned long> (hub.overflows), static_cast<unsigned long> (total.gaps));
+  printf ("ghosts in place %.1f%% of the time, longest off %u ms\n",
+          100.0 * right / std::max<uint64_t> (1, samples), longest);
+  return 0;
+}
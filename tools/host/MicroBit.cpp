@@ -0,0 +1,480 @@
+#include "MicroBit.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ucontext.h>
+
+// Everything here allocates with malloc, so the heap statistics of the
+// game only count the game.
+
+namespace
+{
+
+// Fiber 0 is the main program on the process stack
+int constexpr sMaxFibers = 16;
+size_t constexpr sStackSize = 256 * 1024;
+
+enum State {
+  Free = 0, Ready, Sleeping, Waiting, Done
+};
+
+struct Fiber {
+  ucontext_t context;
+  void* stack = nullptr;
+  void (*entry) () = nullptr;
+  State state = Free;
+  // Sleeping: virtual time of the wake up in us
+  uint64_t wake = 0;
+  // Waiting: the event, 0 matches any
+  uint16_t id = 0;
+  uint16_t value = 0;
+};
+
+Fiber sFibers [sMaxFibers];
+int sCurrent = 0;
+bool sStarted = false;
+
+// the virtual clock in us
+uint64_t sNow = 0;
+
+struct Listener {
+  uint16_t id;
+  uint16_t value;
+  void (*handler) (MicroBitEvent);
+};
+
+int constexpr sMaxListeners = 16;
+Listener sListeners [sMaxListeners];
+
+// The one animation the display runs, its complete event is due then
+bool sAnimating = false;
+uint64_t sAnimationDue = 0;
+
+uint8_t sFrame [25];
+DisplayMode sDisplayMode = DISPLAY_MODE_BLACK_AND_WHITE;
+char sScrolled [64];
+host::Stats sStats;
+
+uint32_t sRandom = 1;
+std::FILE* sSerial = stdout;
+
+void start ()
+{
+  if (sStarted)
+    return;
+
+  sStarted = true;
+  sFibers [0].state = Ready;
+}
+
+void run ()
+{
+  sFibers [sCurrent].entry ();
+  release_fiber ();
+}
+
+bool matches (uint16_t const wanted, uint16_t const given)
+{
+  return 0 == wanted || wanted == given;
+}
+
+// Makes the fibers waiting for the event ready
+void wake (uint16_t const id, uint16_t const value)
+{
+  for (auto& fiber : sFibers)
+    if (Waiting == fiber.state && matches (fiber.id, id) && matches (fiber.value, value))
+      fiber.state = Ready;
+}
+
+// The next ready fiber after the current one, the current one last
+int next ()
+{
+  for (int i = 1; i <= sMaxFibers; ++i)
+  {
+    auto const index = (sCurrent + i) % sMaxFibers;
+    if (Ready == sFibers [index].state)
+      return index;
+  }
+  return -1;
+}
+
+// Moves the clock to the next sleeper or animation and wakes them
+void advance ()
+{
+  uint64_t due = UINT64_MAX;
+  for (auto const& fiber : sFibers)
+    if (Sleeping == fiber.state && fiber.wake < due)
+      due = fiber.wake;
+  if (sAnimating && sAnimationDue < due)
+    due = sAnimationDue;
+
+  if (UINT64_MAX == due)
+  {
+    fprintf (stderr, "host: all fibers wait for events that never come\n");
+    abort ();
+  }
+
+  if (due > sNow)
+    sNow = due;
+  for (auto& fiber : sFibers)
+    if (Sleeping == fiber.state && fiber.wake <= sNow)
+      fiber.state = Ready;
+  if (sAnimating && sAnimationDue <= sNow)
+  {
+    sAnimating = false;
+    MicroBitEvent (MICROBIT_ID_DISPLAY, MICROBIT_DISPLAY_EVT_ANIMATION_COMPLETE);
+  }
+}
+
+}
+
+MicroBitEvent::MicroBitEvent (uint16_t const source, uint16_t const value)
+  : source (source)
+  , value (value)
+  , timestamp (sNow)
+{
+  // a handler may ignore itself
+  for (auto const& listener : sListeners)
+    if (listener.handler && matches (listener.id, source) && matches (listener.value, value))
+      listener.handler (*this);
+  wake (source, value);
+}
+
+MicroBitEvent::MicroBitEvent ()
+  : source (0)
+  , value (0)
+  , timestamp (sNow)
+{
+}
+
+void MicroBitDisplay::print (MicroBitImage const& image)
+{
+  memset (sFrame, 0, sizeof (sFrame));
+  if (5 == image.getWidth () && 5 == image.getHeight ())
+    memcpy (sFrame, image.getBitmap (), sizeof (sFrame));
+  ++sStats.frames;
+}
+
+void MicroBitDisplay::clear ()
+{
+  memset (sFrame, 0, sizeof (sFrame));
+}
+
+void MicroBitDisplay::setDisplayMode (DisplayMode const mode)
+{
+  sDisplayMode = mode;
+}
+
+void MicroBitDisplay::setBrightness (int)
+{
+}
+
+void MicroBitDisplay::scrollAsync (char const* text, int const delay)
+{
+  snprintf (sScrolled, sizeof (sScrolled), "%s", text);
+  // five columns and a gap per character, then out of the display
+  auto const columns = strlen (text) * 6 + 5;
+  sAnimating = true;
+  sAnimationDue = sNow + columns * static_cast<uint64_t> (delay) * 1000;
+}
+
+MicroBitFont MicroBitDisplay::getFont ()
+{
+  static unsigned char const blank [(MICROBIT_FONT_ASCII_END - MICROBIT_FONT_ASCII_START + 1) * MICROBIT_FONT_HEIGHT] = {};
+  MicroBitFont font;
+  font.characters = blank;
+  font.asciiEnd = MICROBIT_FONT_ASCII_END;
+  return font;
+}
+
+int MicroBitSerial::printf (char const* format, ...)
+{
+  if (!sSerial)
+    return 0;
+
+  va_list args;
+  va_start (args, format);
+  auto const result = vfprintf (sSerial, format, args);
+  va_end (args);
+  return result;
+}
+
+void MicroBitRgb::setColour (uint8_t, uint8_t, uint8_t, uint8_t)
+{
+  ++sStats.colours;
+}
+
+void MicroBitRgb::off ()
+{
+}
+
+void MicroBitSoundMotor::soundOn (uint16_t)
+{
+  ++sStats.tones;
+}
+
+void MicroBitSoundMotor::soundOff ()
+{
+}
+
+int MicroBitMessageBus::listen (uint16_t const id, uint16_t const value, void (*handler) (MicroBitEvent), uint16_t)
+{
+  Listener* free = nullptr;
+  for (auto& listener : sListeners)
+  {
+    if (listener.handler == handler && listener.id == id && listener.value == value)
+      return MICROBIT_NOT_SUPPORTED;
+    if (!listener.handler && !free)
+      free = &listener;
+  }
+  if (!free)
+    microbit_panic (MICROBIT_NOT_SUPPORTED);
+
+  free->id = id;
+  free->value = value;
+  free->handler = handler;
+  return MICROBIT_OK;
+}
+
+int MicroBitMessageBus::ignore (uint16_t const id, uint16_t const value, void (*handler) (MicroBitEvent))
+{
+  for (auto& listener : sListeners)
+    if (listener.handler == handler && listener.id == id && listener.value == value)
+      listener.handler = nullptr;
+  return MICROBIT_OK;
+}
+
+int MicroBitRadioDatagram::send (uint8_t*, int)
+{
+  return MICROBIT_NOT_SUPPORTED;
+}
+
+int MicroBitRadioDatagram::recv (uint8_t*, int)
+{
+  return 0;
+}
+
+int MicroBitRadio::enable ()
+{
+  return MICROBIT_NOT_SUPPORTED;
+}
+
+int MicroBitRadio::setGroup (uint8_t)
+{
+  return MICROBIT_NOT_SUPPORTED;
+}
+
+void MicroBit::init ()
+{
+  start ();
+}
+
+void MicroBit::sleep (uint32_t const ms)
+{
+  start ();
+  auto& fiber = sFibers [sCurrent];
+  fiber.state = Sleeping;
+  fiber.wake = sNow + static_cast<uint64_t> (ms) * 1000;
+  schedule ();
+}
+
+unsigned long MicroBit::systemTime ()
+{
+  return static_cast<unsigned long> (sNow / 1000);
+}
+
+void create_fiber (void (*entry) ())
+{
+  start ();
+  for (int i = 1; i < sMaxFibers; ++i)
+  {
+    auto& fiber = sFibers [i];
+    // the stack of the current fiber is still in use until it switches
+    if (i == sCurrent || (Free != fiber.state && Done != fiber.state))
+      continue;
+
+    if (!fiber.stack)
+      fiber.stack = malloc (sStackSize);
+    if (!fiber.stack)
+      microbit_panic (MICROBIT_NOT_SUPPORTED);
+    getcontext (&fiber.context);
+    fiber.context.uc_stack.ss_sp = fiber.stack;
+    fiber.context.uc_stack.ss_size = sStackSize;
+    fiber.context.uc_link = nullptr;
+    makecontext (&fiber.context, run, 0);
+    fiber.entry = entry;
+    fiber.state = Ready;
+    return;
+  }
+  fprintf (stderr, "host: more than %d fibers\n", sMaxFibers);
+  abort ();
+}
+
+void release_fiber ()
+{
+  sFibers [sCurrent].state = Done;
+  schedule ();
+  // only the main fiber gets here, when it is woken up
+}
+
+void schedule ()
+{
+  start ();
+  int index;
+  while (0 > (index = next ()))
+    advance ();
+
+  if (index == sCurrent)
+    return;
+
+  auto const previous = sCurrent;
+  sCurrent = index;
+  ++sStats.switches;
+  swapcontext (&sFibers [previous].context, &sFibers [index].context);
+}
+
+int fiber_wait_for_event (uint16_t const id, uint16_t const value)
+{
+  fiber_wake_on_event (id, value);
+  schedule ();
+  return MICROBIT_OK;
+}
+
+int fiber_wake_on_event (uint16_t const id, uint16_t const value)
+{
+  start ();
+  auto& fiber = sFibers [sCurrent];
+  fiber.state = Waiting;
+  fiber.id = id;
+  fiber.value = value;
+  return MICROBIT_OK;
+}
+
+uint64_t system_timer_current_time_us ()
+{
+  return sNow;
+}
+
+int microbit_random (int const max)
+{
+  if (max <= 0)
+    return 0;
+  // xorshift32
+  sRandom ^= sRandom << 13;
+  sRandom ^= sRandom >> 17;
+  sRandom ^= sRandom << 5;
+  return static_cast<int> (sRandom % static_cast<uint32_t> (max));
+}
+
+uint32_t microbit_serial_number ()
+{
+  return 0x4d415a45;
+}
+
+void microbit_panic (int const code)
+{
+  fprintf (stderr, "host: panic %d\n", code);
+  abort ();
+}
+
+MicroBitImage::MicroBitImage ()
+  : MicroBitImage (0, 0)
+{
+}
+
+MicroBitImage::MicroBitImage (int16_t const width, int16_t const height)
+{
+  auto const size = static_cast<size_t> (width) * static_cast<size_t> (height);
+  mData = static_cast<ImageData*> (malloc (sizeof (ImageData) + size));
+  if (!mData)
+    microbit_panic (MICROBIT_NOT_SUPPORTED);
+  mData->refCount = 1;
+  mData->width = static_cast<uint16_t> (width);
+  mData->height = static_cast<uint16_t> (height);
+  memset (mData->data, 0, size);
+}
+
+MicroBitImage::MicroBitImage (ImageData* const data)
+  : mData (data)
+{
+  retain ();
+}
+
+MicroBitImage::MicroBitImage (MicroBitImage const& image)
+  : mData (image.mData)
+{
+  retain ();
+}
+
+MicroBitImage::~MicroBitImage ()
+{
+  release ();
+}
+
+MicroBitImage& MicroBitImage::operator= (MicroBitImage const& image)
+{
+  if (mData != image.mData)
+  {
+    release ();
+    mData = image.mData;
+    retain ();
+  }
+  return *this;
+}
+
+void MicroBitImage::retain ()
+{
+  if (0xffff != mData->refCount)
+    ++mData->refCount;
+}
+
+void MicroBitImage::release ()
+{
+  if (0xffff != mData->refCount && 0 == --mData->refCount)
+    free (mData);
+}
+
+namespace host
+{
+
+uint8_t const* frame ()
+{
+  return sFrame;
+}
+
+DisplayMode displayMode ()
+{
+  return sDisplayMode;
+}
+
+char const* scrolled ()
+{
+  return sScrolled;
+}
+
+bool listening (uint16_t const id, uint16_t const value)
+{
+  for (auto const& listener : sListeners)
+    if (listener.handler && listener.id == id && listener.value == value)
+      return true;
+  return false;
+}
+
+void seed (uint32_t const seed)
+{
+  sRandom = seed ? seed : 1;
+}
+
+void serial (std::FILE* const file)
+{
+  sSerial = file;
+}
+
+Stats const& stats ()
+{
+  return sStats;
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+// Stand-in for the parts of the MicroBit DAL the game uses, so maze.cpp
+// and its modules run on the build host. Fibers are cooperative like on
+// the device. The clock is virtual: it only moves when every fiber
+// sleeps or waits, and then jumps straight to the next wake up, so a
+// game runs as fast as its code. Events call their listeners right away
+// in the fiber that raised them. The display keeps the last frame, the
+// rgb led and the sound are counted, the radio is never available and
+// the serial goes to stdout or where the host tool sends it.
+
+#include "MicroBitImage.h"
+
+#include <cstdint>
+#include <cstdio>
+
+// ids and values as in the DAL
+#define MICROBIT_OK 0
+#define MICROBIT_NOT_SUPPORTED -1002
+
+#define MICROBIT_ID_ANY 0
+#define MICROBIT_EVT_ANY 0
+#define MICROBIT_ID_BUTTON_A 1
+#define MICROBIT_ID_BUTTON_B 2
+#define MICROBIT_ID_BUTTON_AB 3
+#define MICROBIT_ID_DISPLAY 6
+#define MICROBIT_ID_RADIO 9
+#define MICROBIT_ID_GESTURE 27
+
+#define MICROBIT_BUTTON_EVT_CLICK 3
+#define MICROBIT_BUTTON_EVT_LONG_CLICK 4
+#define MICROBIT_DISPLAY_EVT_ANIMATION_COMPLETE 1
+#define MICROBIT_RADIO_EVT_DATAGRAM 1
+#define MICROBIT_ACCELEROMETER_EVT_SHAKE 11
+
+#define MESSAGE_BUS_LISTENER_DROP_IF_BUSY 0x0004
+#define MESSAGE_BUS_LISTENER_IMMEDIATE 0x0018
+
+#define MICROBIT_FONT_WIDTH 5
+#define MICROBIT_FONT_HEIGHT 5
+#define MICROBIT_FONT_ASCII_START 32
+#define MICROBIT_FONT_ASCII_END 126
+
+enum DisplayMode {
+  DISPLAY_MODE_BLACK_AND_WHITE = 0, DISPLAY_MODE_GREYSCALE
+};
+
+class MicroBitEvent
+{
+public:
+  // raises the event
+  MicroBitEvent (uint16_t source, uint16_t value);
+  MicroBitEvent ();
+
+  uint16_t source;
+  uint16_t value;
+  uint64_t timestamp;
+};
+
+struct MicroBitFont {
+  unsigned char const* characters;
+  int asciiEnd;
+};
+
+class MicroBitDisplay
+{
+public:
+  void print (MicroBitImage const& image);
+  void clear ();
+  void setDisplayMode (DisplayMode mode);
+  void setBrightness (int brightness);
+  // raises the animation complete event when the text would be through
+  void scrollAsync (char const* text, int delay);
+  // blank glyphs
+  MicroBitFont getFont ();
+};
+
+class MicroBitSerial
+{
+public:
+  int printf (char const* format, ...);
+};
+
+class MicroBitRgb
+{
+public:
+  void setColour (uint8_t red, uint8_t green, uint8_t blue, uint8_t white);
+  void off ();
+};
+
+class MicroBitSoundMotor
+{
+public:
+  void soundOn (uint16_t hertz);
+  void soundOff ();
+};
+
+class MicroBitMessageBus
+{
+public:
+  int listen (uint16_t id, uint16_t value, void (*handler) (MicroBitEvent), uint16_t flags = 0);
+  int ignore (uint16_t id, uint16_t value, void (*handler) (MicroBitEvent));
+};
+
+class MicroBitRadioDatagram
+{
+public:
+  int send (uint8_t* buffer, int length);
+  int recv (uint8_t* buffer, int length);
+};
+
+class MicroBitRadio
+{
+public:
+  int enable ();
+  int setGroup (uint8_t group);
+
+  MicroBitRadioDatagram datagram;
+};
+
+class MicroBit
+{
+public:
+  void init ();
+  void sleep (uint32_t ms);
+  unsigned long systemTime ();
+
+  MicroBitDisplay display;
+  MicroBitSerial serial;
+  MicroBitRgb rgb;
+  MicroBitSoundMotor soundmotor;
+  MicroBitMessageBus messageBus;
+  MicroBitRadio radio;
+};
+
+void create_fiber (void (*entry) ());
+void release_fiber ();
+void schedule ();
+int fiber_wait_for_event (uint16_t id, uint16_t value);
+int fiber_wake_on_event (uint16_t id, uint16_t value);
+
+uint64_t system_timer_current_time_us ();
+int microbit_random (int max);
+uint32_t microbit_serial_number ();
+void microbit_panic (int code);
+
+// one core and no interrupts
+inline void __disable_irq () {}
+inline void __enable_irq () {}
+inline uint32_t __get_PRIMASK () { return 0; }
+inline void __set_PRIMASK (uint32_t) {}
+
+// What the host tools see of the device
+namespace host
+{
+
+struct Stats {
+  uint64_t switches = 0;
+  uint64_t frames = 0;
+  uint64_t colours = 0;
+  uint64_t tones = 0;
+};
+
+// The 5x5 pixels last printed, as the image held them
+uint8_t const* frame ();
+DisplayMode displayMode ();
+// The text of the last scrollAsync
+char const* scrolled ();
+
+// Whether a listener for exactly this id and value is registered
+bool listening (uint16_t id, uint16_t value);
+
+// Seeds microbit_random
+void seed (uint32_t seed);
+
+// Where the serial goes, stdout unless changed, nowhere if null
+void serial (std::FILE* file);
+
+Stats const& stats ();
+
+}
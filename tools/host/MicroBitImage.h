@@ -0,0 +1,38 @@
+#pragma once
+
+// Stand-in for the MicroBitImage of the DAL on the build host, see
+// MicroBit.h. Images share their reference counted data like on the
+// device, a count of 0xffff marks data that is never freed.
+
+#include <cstdint>
+
+struct ImageData {
+  uint16_t refCount;
+  uint16_t width;
+  uint16_t height;
+  uint8_t data [1];
+};
+
+class MicroBitImage
+{
+public:
+  // the empty image, 0 x 0 pixels
+  MicroBitImage ();
+  MicroBitImage (int16_t width, int16_t height);
+  explicit MicroBitImage (ImageData* data);
+  MicroBitImage (MicroBitImage const& image);
+  ~MicroBitImage ();
+
+  MicroBitImage& operator= (MicroBitImage const& image);
+
+  uint8_t* getBitmap () { return mData->data; }
+  uint8_t const* getBitmap () const { return mData->data; }
+  int getWidth () const { return mData->width; }
+  int getHeight () const { return mData->height; }
+
+private:
+  void retain ();
+  void release ();
+
+  ImageData* mData;
+};
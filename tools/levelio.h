@@ -0,0 +1,122 @@
+#pragma once
+
+// Level reading shared by the host tools
+
+#include "bitmaze.h"
+#include "generator.h"
+#include "levelpack.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tools
+{
+
+struct Level {
+  maze::LevelInfo info;
+  std::vector<uint8_t> tiles;
+};
+
+// Reports the error and exits, defined by each tool
+void fail (std::string const& message);
+
+inline uint8_t direction (char const d)
+{
+  switch (d)
+  {
+  case 'N': return 0;
+  case 'E': return 1;
+  case 'S': return 2;
+  case 'W': return 3;
+  }
+  fail (std::string ("unknown direction ") + d);
+  return 0;
+}
+
+inline Level readText (std::string const& path)
+{
+  std::ifstream file (path);
+  if (!file)
+    fail ("can not open " + path);
+
+  Level level;
+  std::string line;
+  while (std::getline (file, line))
+  {
+    if (line.empty () || '#' == line [0])
+      continue;
+
+    std::istringstream words (line);
+    std::string word;
+    words >> word;
+    if ("start" == word)
+    {
+      char d = 0;
+      words >> level.info.sx >> level.info.sy >> d;
+      level.info.sd = direction (d);
+    }
+    else if ("end" == word)
+      words >> level.info.ex >> level.info.ey;
+    else
+    {
+      if (0 == level.info.height)
+        level.info.width = static_cast<int32_t> (word.size ());
+      else if (static_cast<int32_t> (word.size ()) != level.info.width)
+        fail (path + ": rows differ in length");
+      for (auto const c : word)
+      {
+        if (c < '0' || c > '9')
+          fail (path + ": tiles must be digits");
+        level.tiles.push_back (c - '0');
+      }
+      level.info.height += 1;
+    }
+  }
+  return level;
+}
+
+inline Level generate (std::string const& spec)
+{
+  // gen:SEED:WIDTHxHEIGHT[:wilson]
+  maze::GeneratorConfig config;
+  char algorithm [16] = {};
+  unsigned long seed = 0;
+  if (sscanf (spec.c_str (), "gen:%lu:%dx%d:%15s", &seed, &config.width, &config.height, algorithm) < 3)
+    fail ("bad generator spec " + spec);
+  config.seed = static_cast<uint32_t> (seed);
+  if (0 == strcmp (algorithm, "wilson"))
+    config.algorithm = maze::Wilson;
+
+  maze::BitMaze bitMaze;
+  maze::DistanceField scratch;
+  auto const ends = maze::generate (bitMaze, scratch, config);
+
+  Level level;
+  level.info.width = bitMaze.width ();
+  level.info.height = bitMaze.height ();
+  level.info.sx = ends.sx;
+  level.info.sy = ends.sy;
+  level.info.ex = ends.ex;
+  level.info.ey = ends.ey;
+
+  int32_t const dx [4] = {0, 1, 0, -1};
+  int32_t const dy [4] = {-1, 0, 1, 0};
+  for (uint8_t di = 0; di < 4; ++di)
+    if (!bitMaze.test (maze::LayerBlocking, ends.sx + dx [di], ends.sy + dy [di]))
+    {
+      level.info.sd = di;
+      break;
+    }
+
+  for (int32_t y = 0; y < bitMaze.height (); ++y)
+    for (int32_t x = 0; x < bitMaze.width (); ++x)
+      level.tiles.push_back (bitMaze.tile (x, y));
+  return level;
+}
+
+}
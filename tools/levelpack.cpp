@@ -0,0 +1,201 @@
+// Level pack encoder, runs on the build host.
+//
+// Build:
+//   g++ -std=c++11 -O2 -Isource -o levelpack tools/levelpack.cpp
+//       source/bitmaze.cpp source/distance.cpp source/generator.cpp
+//
+// Usage:
+//   levelpack [-o levels.cpp] [-b levels.bin] level...
+//
+// A level is either a text file or gen:SEED:WIDTHxHEIGHT[:wilson] for a
+// generated one. Text files hold one digit per tile and row plus the lines
+//   start X Y N|E|S|W
+//   end X Y
+// Lines starting with # are comments. See levels/ for examples.
+
+#include "levelio.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace tools
+{
+
+void fail (std::string const& message)
+{
+  fprintf (stderr, "levelpack: %s\n", message.c_str ());
+  exit (1);
+}
+
+}
+
+namespace
+{
+
+using tools::Level;
+using tools::fail;
+
+class BitWriter
+{
+public:
+  void write (uint32_t const value, uint8_t const bits)
+  {
+    for (uint8_t i = 0; i < bits; ++i, ++mBit)
+    {
+      if (0 == (mBit & 7))
+        mData.push_back (0);
+      if (value & (1u << i))
+        mData.back () |= 1 << (mBit & 7);
+    }
+  }
+
+  std::vector<uint8_t> const& data () const { return mData; }
+
+private:
+  std::vector<uint8_t> mData;
+  uint32_t mBit = 0;
+};
+
+void put16 (std::vector<uint8_t>& out, uint32_t const value)
+{
+  out.push_back (value & 0xff);
+  out.push_back ((value >> 8) & 0xff);
+}
+
+void set32 (std::vector<uint8_t>& out, size_t const at, uint32_t const value)
+{
+  for (int i = 0; i < 4; ++i)
+    out [at + i] = (value >> (8 * i)) & 0xff;
+}
+
+int code (uint8_t const tile)
+{
+  for (int i = 0; i < 6; ++i)
+    if (maze::sPackTiles [i] == tile)
+      return i;
+  return -1;
+}
+
+std::vector<uint8_t> encodeRow (uint8_t const* tiles, int32_t const width)
+{
+  BitWriter writer;
+  for (int32_t x = 0; x < width;)
+  {
+    int32_t run = 0;
+    while (x + run < width && 9 == tiles [x + run] && run < maze::sPackRunMax)
+      ++run;
+
+    if (run >= maze::sPackRunMin)
+    {
+      writer.write (maze::sPackCodeRun, maze::sPackCodeBits);
+      writer.write (run - maze::sPackRunMin, maze::sPackRunBits);
+      x += run;
+      continue;
+    }
+
+    auto const tile = tiles [x++];
+    auto const c = code (tile);
+    if (c >= 0)
+      writer.write (c, maze::sPackCodeBits);
+    else if (tile < (1 << maze::sPackEscapeBits))
+    {
+      writer.write (maze::sPackCodeEscape, maze::sPackCodeBits);
+      writer.write (tile, maze::sPackEscapeBits);
+    }
+    else
+      fail ("tile value " + std::to_string (tile) + " can not be packed");
+  }
+  return writer.data ();
+}
+
+std::vector<uint8_t> pack (std::vector<Level> const& levels)
+{
+  std::vector<uint8_t> out = {'M', 'Z', maze::sPackVersion, static_cast<uint8_t> (levels.size ())};
+  auto const offsets = out.size ();
+  out.resize (out.size () + 4 * levels.size ());
+
+  for (size_t i = 0; i < levels.size (); ++i)
+  {
+    auto const& level = levels [i];
+    auto const start = out.size ();
+    set32 (out, offsets + 4 * i, start);
+
+    put16 (out, level.info.width);
+    put16 (out, level.info.height);
+    put16 (out, level.info.sx);
+    put16 (out, level.info.sy);
+    put16 (out, level.info.ex);
+    put16 (out, level.info.ey);
+    out.push_back (level.info.sd);
+    out.push_back (0);
+
+    auto const rows = out.size ();
+    out.resize (out.size () + 4 * level.info.height);
+    for (int32_t y = 0; y < level.info.height; ++y)
+    {
+      set32 (out, rows + 4 * y, out.size () - start);
+      auto const row = encodeRow (&level.tiles [y * level.info.width], level.info.width);
+      out.insert (out.end (), row.begin (), row.end ());
+    }
+  }
+  return out;
+}
+
+void writeSource (std::string const& path, std::vector<uint8_t> const& data)
+{
+  FILE* file = path.empty () ? stdout : fopen (path.c_str (), "w");
+  if (!file)
+    fail ("can not write " + path);
+
+  fprintf (file, "// Generated by tools/levelpack.cpp, do not edit.\n\n");
+  fprintf (file, "#include \"levelpack.h\"\n\nnamespace maze\n{\n\n");
+  fprintf (file, "uint8_t const sLevelPack [] = {");
+  for (size_t i = 0; i < data.size (); ++i)
+    fprintf (file, "%s0x%02x%s", (0 == i % 12) ? "\n  " : "", data [i], (i + 1 < data.size ()) ? ", " : "");
+  fprintf (file, "\n};\n\n}\n");
+
+  if (file != stdout)
+    fclose (file);
+}
+
+}
+
+int main (int argc, char** argv)
+{
+  std::string source;
+  std::string binary;
+  std::vector<Level> levels;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv [i];
+    if ("-o" == arg && i + 1 < argc)
+      source = argv [++i];
+    else if ("-b" == arg && i + 1 < argc)
+      binary = argv [++i];
+    else if (0 == arg.compare (0, 4, "gen:"))
+      levels.push_back (tools::generate (arg));
+    else
+      levels.push_back (tools::readText (arg));
+  }
+
+  if (levels.empty () || levels.size () > 255)
+    fail ("usage: levelpack [-o levels.cpp] [-b levels.bin] level...");
+
+  auto const data = pack (levels);
+  writeSource (source, data);
+  if (!binary.empty ())
+  {
+    std::ofstream file (binary, std::ios::binary);
+    file.write (reinterpret_cast<char const*> (data.data ()), data.size ());
+  }
+
+  size_t cells = 0;
+  for (auto const& level : levels)
+    cells += level.tiles.size ();
+  fprintf (stderr, "levelpack: %zu levels, %zu cells, %zu bytes\n", levels.size (), cells, data.size ());
+  return 0;
+}
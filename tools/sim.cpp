@@ -0,0 +1,342 @@
+// Whole games of the device program, runs on the build host.
+//
+// Build with cmake, the maze_sim target. It links maze::run and all
+// modules of source/ but main.cpp against the stand-in of the DAL in
+// tools/host, see tools/host/MicroBit.h.
+//
+// Usage:
+//   maze_sim [-g GAMES] [-s SEED] [-o LATENCY] [-v]
+//
+// Plays GAMES games one after the other like the device plays them after
+// a reset, title and end animation included. A player fiber presses the
+// buttons like a player who knows the level: it walks down the distance
+// field of the game to the goal around the traps, turns at random now
+// and then and shakes for the map and back. Without a distance field it
+// follows the wall on its right from what the display shows. The clock
+// of the stand-in is virtual, so nothing sleeps for real. The save log
+// goes to a page in memory. Prints the games won and lost on traps, the
+// presses, the fiber switches, the wake ups of the rgb led fiber and its
+// colour changes, the title frames, the virtual and the wall time and the
+// games and presses per second of wall time as one CSV line, then the
+// heap statistics of the game. Fails if a title frame allocated. The
+// serial output of the games is only shown with -v. With -o the input
+// latencies of all games go to the file LATENCY as CSV: per handler and
+// stage the events received and handled and the histogram of the virtual
+// us from the event to the game logic and to the output.
+
+#include "heap.h"
+#include "latency.h"
+#include "maze.h"
+#include "savegame.h"
+
+#include <MicroBit.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+MicroBit uBit;
+
+namespace
+{
+
+// virtual ms between two presses, at least the tilt after a bump
+uint32_t constexpr sMinPause = 100;
+uint32_t constexpr sPauseRange = 100;
+// one press in this many is a random button, a shake to the map and back
+uint32_t constexpr sRandomEvery = 8;
+uint32_t constexpr sMapEvery = 32;
+// virtual ms between two looks whether the game takes inputs
+uint32_t constexpr sPoll = 50;
+
+// Pixels of the depth view that are full bright if the wall in front or
+// on the right of the player is there
+int constexpr sFrontPixel = 1 * 5 + 1;
+int constexpr sRightPixel = 2 * 5 + 4;
+uint8_t constexpr sNearWall = 255;
+
+struct Options {
+  uint32_t games = 1000;
+  uint32_t seed = 1;
+  // latency report, none if null
+  char const* latency = nullptr;
+  // the serial output of every game
+  bool verbose = false;
+};
+
+// The page of the save log, erased words read all ones
+class MemoryFlash : public maze::save::Flash
+{
+public:
+  explicit MemoryFlash (uint32_t const words)
+    : mWords (words, 0xffffffff)
+  {
+  }
+
+  uint32_t words () const override { return static_cast<uint32_t> (mWords.size ()); }
+  uint32_t read (uint32_t const word) const override { return mWords [word]; }
+
+  void write (uint32_t const word, uint32_t const* data, uint32_t const count) override
+  {
+    for (uint32_t i = 0; i < count; ++i)
+      mWords [word + i] &= data [i];
+  }
+
+  void erase () override { mWords.assign (mWords.size (), 0xffffffff); }
+
+private:
+  std::vector<uint32_t> mWords;
+};
+
+std::mt19937 sRandom;
+bool sPlayerActive = false;
+uint64_t sPresses = 0;
+
+// The title draws into one reused image, its frames must not allocate
+uint64_t sTitleFrames = 0;
+uint32_t sTitleAllocations = 0;
+
+// One CSV line per handler and stage with the events received and
+// handled, the summary of its histogram and the count of every bucket
+bool writeLatency (char const* path)
+{
+  auto* const file = fopen (path, "w");
+  if (!file)
+    return false;
+
+  fprintf (file, "handler,stage,received,handled,dropped,n,min_us,mean_us,p50_us,p99_us,max_us");
+  for (uint8_t i = 0; i < maze::Histogram::sBuckets; ++i)
+    fprintf (file, ",bucket%u", static_cast<unsigned> (i));
+  fprintf (file, "\n");
+
+  for (int handler = 0; handler < maze::latency::HandlerCount; ++handler)
+  {
+    auto const kind = static_cast<maze::latency::Handler> (handler);
+    auto const& stats = maze::latency::stats (kind);
+    auto const dropped = (stats.received > stats.handled) ? stats.received - stats.handled : 0;
+    maze::Histogram const* const histograms [2] = {&stats.logic, &stats.output};
+    char const* const stages [2] = {"logic", "output"};
+    for (int stage = 0; stage < 2; ++stage)
+    {
+      auto const& histogram = *histograms [stage];
+      fprintf (file, "%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+               maze::latency::name (kind), stages [stage],
+               static_cast<unsigned long> (stats.received),
+               static_cast<unsigned long> (stats.handled),
+               static_cast<unsigned long> (dropped),
+               static_cast<unsigned long> (histogram.count ()),
+               static_cast<unsigned long> (histogram.min ()),
+               static_cast<unsigned long> (histogram.mean ()),
+               static_cast<unsigned long> (histogram.percentile (50)),
+               static_cast<unsigned long> (histogram.percentile (99)),
+               static_cast<unsigned long> (histogram.max ()));
+      for (uint8_t i = 0; i < maze::Histogram::sBuckets; ++i)
+        fprintf (file, ",%lu", static_cast<unsigned long> (histogram.bucket (i)));
+      fprintf (file, "\n");
+    }
+  }
+  return 0 == fclose (file);
+}
+
+// The game listens to the buttons and shows the depth view or the map
+bool playing ()
+{
+  return host::listening (MICROBIT_ID_BUTTON_AB, MICROBIT_BUTTON_EVT_CLICK) &&
+         DISPLAY_MODE_GREYSCALE == host::displayMode ();
+}
+
+// Raises the event like the button or the accelerometer would, then
+// waits for the game to show its answer
+void press (uint16_t const id, uint16_t const value)
+{
+  MicroBitEvent (id, value);
+  ++sPresses;
+  uBit.sleep (sMinPause + sRandom () % sPauseRange);
+}
+
+void click (uint16_t const id)
+{
+  press (id, MICROBIT_BUTTON_EVT_CLICK);
+}
+
+// The direction of the neighbour nearer to the goal than the player, -1
+// if there is no distance field to follow. Traps read as unreachable.
+int nearerDirection (maze::PlayerState const& state)
+{
+  static int32_t const dx [4] = {0, 1, 0, -1};
+  static int32_t const dy [4] = {-1, 0, 1, 0};
+
+  auto best = maze::safeDistance (state.px, state.py);
+  int direction = -1;
+  for (int i = 0; i < 4; ++i)
+  {
+    auto const distance = maze::safeDistance (state.px + dx [i], state.py + dy [i]);
+    if (distance < best)
+    {
+      best = distance;
+      direction = i;
+    }
+  }
+  return direction;
+}
+
+// The player fiber of one game, it counts the frames and allocations of
+// the title from its first look to its last while it waits
+void player ()
+{
+  sPlayerActive = true;
+  bool title = false;
+  uint64_t frames = 0;
+  uint32_t allocations = 0;
+  while (!playing ())
+  {
+    if (maze::titleActive)
+    {
+      if (title)
+      {
+        sTitleFrames += host::stats ().frames - frames;
+        sTitleAllocations += maze::heap::allocations () - allocations;
+      }
+      title = true;
+      frames = host::stats ().frames;
+      allocations = maze::heap::allocations ();
+    }
+    uBit.sleep (sPoll);
+  }
+
+  // the last press turned right, the step into the new corridor follows
+  bool turned = false;
+  while (playing ())
+  {
+    uint8_t pixels [25];
+    memcpy (pixels, host::frame (), sizeof (pixels));
+    auto const front = sNearWall == pixels [sFrontPixel];
+    auto const right = sNearWall == pixels [sRightPixel];
+    auto const state = maze::playerState ();
+    auto const nearer = nearerDirection (state);
+
+    if (0 == sRandom () % sMapEvery)
+    {
+      press (MICROBIT_ID_GESTURE, MICROBIT_ACCELEROMETER_EVT_SHAKE);
+      press (MICROBIT_ID_GESTURE, MICROBIT_ACCELEROMETER_EVT_SHAKE);
+    }
+    else if (0 == sRandom () % sRandomEvery)
+    {
+      // a random turn, a random step could end on a trap
+      click ((sRandom () & 1) ? MICROBIT_ID_BUTTON_A : MICROBIT_ID_BUTTON_B);
+      turned = false;
+    }
+    else if (0 <= nearer)
+    {
+      if (nearer == state.di)
+        click (MICROBIT_ID_BUTTON_AB);
+      else if (nearer == ((state.di + 1) & 3))
+        click (MICROBIT_ID_BUTTON_B);
+      else
+        click (MICROBIT_ID_BUTTON_A);
+    }
+    else if (turned && !front)
+    {
+      click (MICROBIT_ID_BUTTON_AB);
+      turned = false;
+    }
+    else if (!right)
+    {
+      click (MICROBIT_ID_BUTTON_B);
+      turned = true;
+    }
+    else if (!front)
+      click (MICROBIT_ID_BUTTON_AB);
+    else
+      click (MICROBIT_ID_BUTTON_A);
+  }
+  sPlayerActive = false;
+}
+
+}
+
+int main (int argc, char** argv)
+{
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv [i];
+    if ("-g" == arg && i + 1 < argc)
+      options.games = static_cast<uint32_t> (std::max (1, atoi (argv [++i])));
+    else if ("-s" == arg && i + 1 < argc)
+      options.seed = static_cast<uint32_t> (atoi (argv [++i]));
+    else if ("-o" == arg && i + 1 < argc)
+      options.latency = argv [++i];
+    else if ("-v" == arg)
+      options.verbose = true;
+    else
+    {
+      fprintf (stderr, "usage: maze_sim [-g games] [-s seed] [-o latency.csv] [-v]\n");
+      return 1;
+    }
+  }
+
+  MemoryFlash flash (256);
+  maze::save::use (flash);
+  host::seed (options.seed);
+  sRandom.seed (options.seed);
+  uBit.init ();
+  if (!options.verbose)
+    host::serial (nullptr);
+
+  uint32_t victories = 0;
+  uint32_t traps = 0;
+  maze::PulseStats pulse;
+  auto const begin = std::chrono::steady_clock::now ();
+  for (uint32_t game = 0; game < options.games; ++game)
+  {
+    create_fiber (player);
+    maze::run ();
+    while (sPlayerActive)
+      uBit.sleep (sPoll);
+
+    auto const& stats = maze::pulseStats ();
+    pulse.wakeups += stats.wakeups;
+    pulse.colourChanges += stats.colourChanges;
+
+    if (0 == strcmp ("Victory!", host::scrolled ()))
+      ++victories;
+    else if (0 == strcmp ("Trap!", host::scrolled ()))
+      ++traps;
+  }
+  auto const seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - begin).count ();
+  auto const virtualSeconds = static_cast<double> (system_timer_current_time_us ()) / 1e6;
+
+  printf ("games,victories,traps,presses,switches,pulse_wakeups,colour_changes,"
+          "title_frames,virtual_s,wall_s,games_per_s,presses_per_s\n");
+  printf ("%u,%u,%u,%llu,%llu,%lu,%lu,%llu,%.0f,%.3f,%.0f,%.0f\n",
+          options.games, victories, traps,
+          static_cast<unsigned long long> (sPresses),
+          static_cast<unsigned long long> (host::stats ().switches),
+          static_cast<unsigned long> (pulse.wakeups),
+          static_cast<unsigned long> (pulse.colourChanges),
+          static_cast<unsigned long long> (sTitleFrames),
+          virtualSeconds, seconds,
+          options.games / seconds, static_cast<double> (sPresses) / seconds);
+  host::serial (stdout);
+  maze::heap::print ();
+
+  if (0 == sTitleFrames || 0 != sTitleAllocations)
+  {
+    fprintf (stderr, "title: %lu allocations in %llu frames\n",
+             static_cast<unsigned long> (sTitleAllocations),
+             static_cast<unsigned long long> (sTitleFrames));
+    return 1;
+  }
+  if (options.latency && !writeLatency (options.latency))
+  {
+    fprintf (stderr, "cannot write %s\n", options.latency);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,293 @@
+// Level validator, runs on the build host.
+//
+// Build:
+//   g++ -std=c++11 -O2 -pthread -Isource -o validate tools/validate.cpp
+//       source/bitmaze.cpp source/distance.cpp source/generator.cpp
+//       source/levelpack.cpp source/validate.cpp tools/difficulty.cpp
+//
+// Usage:
+//   validate [-j THREADS] [-v] [-d] level...
+//
+// A level is a text file, a pack written with levelpack -b (*.bin) or
+// gen:SEED[-LAST]:WIDTHxHEIGHT[:wilson] for a range of generated ones.
+// The levels are checked on a pool of threads, each with its own queue,
+// idle threads steal from the others. With -d the levels are ranked by the
+// expected presses to the goal. Exits with 1 if a level is invalid.
+
+#include "difficulty.h"
+#include "levelio.h"
+#include "validate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace tools
+{
+
+void fail (std::string const& message)
+{
+  fprintf (stderr, "validate: %s\n", message.c_str ());
+  exit (1);
+}
+
+}
+
+namespace
+{
+
+using tools::Level;
+using tools::fail;
+
+struct Job {
+  std::string name;
+  // gen: spec, a text file or a level of a pack
+  std::string spec;
+  std::vector<uint8_t> const* pack = nullptr;
+  uint8_t level = 0;
+};
+
+struct Result {
+  std::string name;
+  maze::Report report;
+  maze::Difficulty difficulty;
+  int32_t width = 0;
+  int32_t height = 0;
+};
+
+class Worker
+{
+public:
+  bool pop (Job& job)
+  {
+    std::lock_guard<std::mutex> lock (mMutex);
+    if (mJobs.empty ())
+      return false;
+    job = std::move (mJobs.back ());
+    mJobs.pop_back ();
+    return true;
+  }
+
+  bool steal (Job& job)
+  {
+    std::lock_guard<std::mutex> lock (mMutex);
+    if (mJobs.empty ())
+      return false;
+    job = std::move (mJobs.front ());
+    mJobs.pop_front ();
+    return true;
+  }
+
+  void push (Job job)
+  {
+    std::lock_guard<std::mutex> lock (mMutex);
+    mJobs.push_back (std::move (job));
+  }
+
+  std::vector<Result> results;
+  size_t cells = 0;
+  size_t stolen = 0;
+  double seconds = 0;
+
+private:
+  std::mutex mMutex;
+  std::deque<Job> mJobs;
+};
+
+std::vector<uint8_t> readFile (std::string const& path)
+{
+  std::ifstream file (path, std::ios::binary);
+  if (!file)
+    fail ("can not open " + path);
+  return std::vector<uint8_t> (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+}
+
+Level unpack (std::vector<uint8_t> const& data, uint8_t const index)
+{
+  maze::LevelPack const pack (data.data ());
+  Level level;
+  level.info = pack.info (index);
+  level.tiles.resize (static_cast<size_t> (level.info.width) * level.info.height);
+  for (int32_t y = 0; y < level.info.height; ++y)
+    pack.row (index, y, &level.tiles [y * level.info.width]);
+  return level;
+}
+
+Result check (Job const& job, bool const solve)
+{
+  Level const level = job.pack
+    ? unpack (*job.pack, job.level)
+    : (0 == job.spec.compare (0, 4, "gen:") ? tools::generate (job.spec) : tools::readText (job.spec));
+
+  maze::BitMaze bitMaze;
+  bitMaze.assign (level.tiles.data (), level.info.width, level.info.height);
+
+  Result result;
+  result.name = job.name;
+  result.width = level.info.width;
+  result.height = level.info.height;
+  result.report = maze::validate (bitMaze, level.info.sx, level.info.sy, level.info.ex, level.info.ey);
+  if (solve)
+  {
+    result.difficulty = maze::solve (bitMaze,
+      level.info.sx, level.info.sy, level.info.sd, level.info.ex, level.info.ey);
+  }
+  return result;
+}
+
+void run (std::vector<Worker>& workers, size_t const self, bool const solve)
+{
+  auto const begin = std::chrono::steady_clock::now ();
+  auto& worker = workers [self];
+  Job job;
+  for (;;)
+  {
+    bool found = worker.pop (job);
+    for (size_t i = 1; !found && i < workers.size (); ++i)
+    {
+      found = workers [(self + i) % workers.size ()].steal (job);
+      worker.stolen += found;
+    }
+    if (!found)
+      break;
+
+    worker.results.push_back (check (job, solve));
+    worker.cells += static_cast<size_t> (worker.results.back ().width) * worker.results.back ().height;
+  }
+  worker.seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - begin).count ();
+}
+
+void addGenerated (std::vector<Job>& jobs, std::string const& arg)
+{
+  // gen:SEED-LAST:REST expands to gen:SEED:REST ... gen:LAST:REST
+  unsigned long first = 0;
+  unsigned long last = 0;
+  int used = 0;
+  if (2 == sscanf (arg.c_str (), "gen:%lu-%lu%n", &first, &last, &used) && last >= first)
+  {
+    auto const rest = arg.substr (used);
+    for (auto seed = first; seed <= last; ++seed)
+    {
+      Job job;
+      job.spec = "gen:" + std::to_string (seed) + rest;
+      job.name = job.spec;
+      jobs.push_back (job);
+    }
+  }
+  else
+  {
+    Job job;
+    job.spec = arg;
+    job.name = arg;
+    jobs.push_back (job);
+  }
+}
+
+}
+
+int main (int argc, char** argv)
+{
+  size_t threads = std::max (1u, std::thread::hardware_concurrency ());
+  bool verbose = false;
+  bool solve = false;
+  std::deque<std::vector<uint8_t>> packs;
+  std::vector<Job> jobs;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv [i];
+    if ("-j" == arg && i + 1 < argc)
+      threads = std::max (1, atoi (argv [++i]));
+    else if ("-v" == arg)
+      verbose = true;
+    else if ("-d" == arg)
+      solve = true;
+    else if (0 == arg.compare (0, 4, "gen:"))
+      addGenerated (jobs, arg);
+    else if (arg.size () > 4 && 0 == arg.compare (arg.size () - 4, 4, ".bin"))
+    {
+      packs.push_back (readFile (arg));
+      if (!maze::LevelPack (packs.back ().data ()).valid ())
+        fail (arg + " is no level pack");
+      for (uint8_t l = 0; l < maze::LevelPack (packs.back ().data ()).count (); ++l)
+      {
+        Job job;
+        job.name = arg + "#" + std::to_string (l);
+        job.pack = &packs.back ();
+        job.level = l;
+        jobs.push_back (job);
+      }
+    }
+    else
+    {
+      Job job;
+      job.spec = arg;
+      job.name = arg;
+      jobs.push_back (job);
+    }
+  }
+
+  if (jobs.empty ())
+    fail ("usage: validate [-j threads] [-v] [-d] level...");
+
+  threads = std::min (threads, jobs.size ());
+  std::vector<Worker> workers (threads);
+  for (size_t i = 0; i < jobs.size (); ++i)
+    workers [i % threads].push (std::move (jobs [i]));
+
+  auto const begin = std::chrono::steady_clock::now ();
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i)
+    pool.emplace_back (run, std::ref (workers), i, solve);
+  run (workers, 0, solve);
+  for (auto& thread : pool)
+    thread.join ();
+  auto const seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - begin).count ();
+
+  std::vector<Result> results;
+  for (auto& worker : workers)
+    results.insert (results.end (), worker.results.begin (), worker.results.end ());
+  std::sort (results.begin (), results.end (),
+    [solve] (Result const& a, Result const& b)
+    {
+      return solve ? a.difficulty.moves > b.difficulty.moves : a.name < b.name;
+    });
+
+  size_t invalid = 0;
+  size_t cells = 0;
+  size_t reachable = 0;
+  size_t secrets = 0;
+  size_t shortcuts = 0;
+  for (auto const& result : results)
+  {
+    auto const& report = result.report;
+    invalid += !report.valid ();
+    cells += static_cast<size_t> (result.width) * result.height;
+    reachable += report.reachableCells;
+    secrets += report.secretWalls;
+    shortcuts += report.shortcuts;
+    if (verbose || !report.valid ())
+      printf ("%-32s %s %dx%d reachable %u%s%s twister loops %u secret walls %u shortcuts %u\n",
+        result.name.c_str (), report.valid () ? "ok     " : "INVALID",
+        result.width, result.height, report.reachableCells,
+        report.closedBorder ? "" : " open border",
+        report.reachable ? "" : " goal unreachable",
+        report.twisterLoops, report.secretWalls, report.shortcuts);
+    // the ranking, under the report if there is one
+    if (solve)
+      printf ("%-32s expected presses %.1f, trap chance %.1f%%, %u updates\n",
+        (verbose || !report.valid ()) ? "" : result.name.c_str (), result.difficulty.moves, 100.0f * result.difficulty.trapChance, result.difficulty.updates);
+  }
+
+  printf ("%zu levels, %zu invalid, %zu cells, %zu reachable, %zu secret walls, %zu shortcuts\n",
+    results.size (), invalid, cells, reachable, secrets, shortcuts);
+  for (size_t i = 0; i < workers.size (); ++i)
+    printf ("thread %zu: %zu levels, %zu stolen, %.2f levels/s, %.1f Mcells/s\n",
+      i, workers [i].results.size (), workers [i].stolen,
+      workers [i].seconds > 0 ? workers [i].results.size () / workers [i].seconds : 0.0,
+      workers [i].seconds > 0 ? workers [i].cells / workers [i].seconds / 1e6 : 0.0);
+  printf ("%.3f s, %.2f levels/s\n", seconds, seconds > 0 ? results.size () / seconds : 0.0);
+  return invalid ? 1 : 0;
+}